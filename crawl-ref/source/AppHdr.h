@@ -259,6 +259,18 @@ static inline double pow(int x, double y) { return std::pow((double)x, y); }
 //
 // #define CLUA_BINDINGS
 
+// =========================================================================
+//  Line of sight
+// =========================================================================
+//
+// Compute field of view with the bit-packed ray mask engine instead of the
+// cell-by-cell raycaster (see los.cc). Both give identical results, which
+// test/los_symm.lua and test/los_csc.lua verify. The bitmask engine uses
+// SSE2 or AVX2 when the compiler targets them. Can also be enabled with
+// "make LOS_BITMASK=y".
+//
+// #define USE_LOS_BITMASK
+
 // =========================================================================
 //  Game Play Defines
 // =========================================================================
@@ -5,15 +5,38 @@
 #include "env.h"
 #include "losglobal.h"
 
+monster_cells::monster_cells(coord_def c, int radius)
+    : count(0)
+{
+    ASSERT(radius <= LOS_RADIUS);
+    if (radius < 0)
+        return;
+
+    const int x1 = max(c.x - radius, 0), x2 = min(c.x + radius, GXM - 1);
+    const int y1 = max(c.y - radius, 0), y2 = min(c.y + radius, GYM - 1);
+    for (int x = x1; x <= x2; ++x)
+        for (int y = y1; y <= y2; ++y)
+            if (env.mgrid[x][y] != NON_MONSTER)
+                indices[count++] = env.mgrid[x][y];
+
+    // Keep to the order a walk over all monsters would see them in.
+    sort(indices, indices + count);
+    count = unique(indices, indices + count) - indices;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
-    : center(c), _los(los), viewer(nullptr), i(-1)
+    : center(c), _los(los), viewer(nullptr),
+      cells(c, los == LOS_NONE ? -1 : LOS_RADIUS), i(-1)
 {
     if (!valid(&you))
         advance();
 }
 
 actor_near_iterator::actor_near_iterator(const actor* a, los_type los)
-    : center(a->pos()), _los(los), viewer(a), i(-1)
+    : center(a->pos()), _los(los), viewer(a),
+      cells(a->pos(), los == LOS_NONE ? -1 : LOS_RADIUS), i(-1)
 {
     if (!valid(&you))
         advance();
@@ -28,8 +51,8 @@ actor* actor_near_iterator::operator*() const
 {
     if (i == -1)
         return &you;
-    else if (i < MAX_MONSTERS)
-        return &env.mons[i];
+    else if (i < end_point())
+        return &env.mons[_los == LOS_NONE ? i : cells[i]];
     else
         return nullptr;
 }
@@ -61,28 +84,38 @@ bool actor_near_iterator::valid(const actor* a) const
     return cell_see_cell(center, a->pos(), _los);
 }
 
+int actor_near_iterator::end_point() const
+{
+    return _los == LOS_NONE ? MAX_MONSTERS : cells.size();
+}
+
 void actor_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
-             return;
+        if (++i >= end_point())
+        {
+            i = end_point();
+            return;
+        }
     while (!valid(**this));
 }
 
 //////////////////////////////////////////////////////////////////////////
 
 monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
-    : center(c), _los(los), viewer(nullptr), i(0)
+    : center(c), _los(los), viewer(nullptr),
+      cells(c, los == LOS_NONE ? -1 : LOS_RADIUS), i(0)
 {
-    if (!valid(&env.mons[0]))
+    if (!valid(**this))
         advance();
     begin_point = i;
 }
 
 monster_near_iterator::monster_near_iterator(const actor *a, los_type los)
-    : center(a->pos()), _los(los), viewer(a), i(0)
+    : center(a->pos()), _los(los), viewer(a),
+      cells(a->pos(), los == LOS_NONE ? -1 : LOS_RADIUS), i(0)
 {
-    if (!valid(&env.mons[0]))
+    if (!valid(**this))
         advance();
     begin_point = i;
 }
@@ -94,8 +127,8 @@ monster_near_iterator::operator bool() const
 
 monster* monster_near_iterator::operator*() const
 {
-    if (i < MAX_MONSTERS)
-        return &env.mons[i];
+    if (i < end_point())
+        return &env.mons[_los == LOS_NONE ? i : cells[i]];
     else
         return nullptr;
 }
@@ -138,7 +171,7 @@ monster_near_iterator monster_near_iterator::begin()
 monster_near_iterator monster_near_iterator::end()
 {
     monster_near_iterator copy = *this;
-    copy.i = MAX_MONSTERS;
+    copy.i = end_point();
     return copy;
 }
 
@@ -151,11 +184,75 @@ bool monster_near_iterator::valid(const monster* a) const
     return cell_see_cell(center, a->pos(), _los);
 }
 
+int monster_near_iterator::end_point() const
+{
+    return _los == LOS_NONE ? MAX_MONSTERS : cells.size();
+}
+
 void monster_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
-             return;
+        if (++i >= end_point())
+        {
+            i = end_point();
+            return;
+        }
+    while (!valid(**this));
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+monster_radius_iterator::monster_radius_iterator(coord_def c, int r)
+    : center(c), radius(r), cells(c, r), i(0)
+{
+    if (!valid(**this))
+        advance();
+}
+
+monster_radius_iterator::operator bool() const
+{
+    return valid(**this);
+}
+
+monster* monster_radius_iterator::operator*() const
+{
+    if (i < cells.size())
+        return &env.mons[cells[i]];
+    else
+        return nullptr;
+}
+
+monster* monster_radius_iterator::operator->() const
+{
+    return **this;
+}
+
+monster_radius_iterator& monster_radius_iterator::operator++()
+{
+    advance();
+    return *this;
+}
+
+monster_radius_iterator monster_radius_iterator::operator++(int)
+{
+    monster_radius_iterator copy = *this;
+    ++(*this);
+    return copy;
+}
+
+bool monster_radius_iterator::valid(const monster* a) const
+{
+    return a && a->alive() && (a->pos() - center).rdist() <= radius;
+}
+
+void monster_radius_iterator::advance()
+{
+    do
+        if (++i >= cells.size())
+        {
+            i = cells.size();
+            return;
+        }
     while (!valid(**this));
 }
 
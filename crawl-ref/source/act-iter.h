@@ -7,6 +7,24 @@
 
 #include "los-type.h"
 
+// The monsters standing within a radius (in the C_SQUARE sense, and no more
+// than LOS_RADIUS) of a cell, in index order. They are found through
+// env.mgrid, so this costs the area searched rather than a look at every
+// monster slot. A negative radius finds nothing.
+class monster_cells
+{
+public:
+    monster_cells(coord_def c, int radius);
+
+    int size() const { return count; }
+    int operator[](int n) const { return indices[n]; }
+
+private:
+    static const int MAX_CELLS = (2 * LOS_RADIUS + 1) * (2 * LOS_RADIUS + 1);
+    short indices[MAX_CELLS];
+    int count;
+};
+
 class actor_near_iterator
 {
 public:
@@ -23,10 +41,13 @@ protected:
     const coord_def center;
     los_type _los;
     const actor* viewer;
+    // Unless _los is LOS_NONE, only these monsters can be in sight.
+    monster_cells cells;
     int i;
 
     bool valid(const actor* a) const;
     void advance();
+    int end_point() const;
 };
 
 class monster_near_iterator
@@ -49,9 +70,35 @@ protected:
     const coord_def center;
     los_type _los;
     const actor* viewer;
+    // Unless _los is LOS_NONE, only these monsters can be in sight.
+    monster_cells cells;
     int i;
     int begin_point;
 
+    bool valid(const monster* a) const;
+    void advance();
+    int end_point() const;
+};
+
+// Iterates over the live monsters within radius (no more than LOS_RADIUS)
+// of a cell, regardless of line of sight, in index order.
+class monster_radius_iterator
+{
+public:
+    monster_radius_iterator(coord_def c, int radius);
+
+    operator bool() const;
+    monster* operator*() const;
+    monster* operator->() const;
+    monster_radius_iterator& operator++();
+    monster_radius_iterator operator++(int);
+
+protected:
+    const coord_def center;
+    const int radius;
+    monster_cells cells;
+    int i;
+
     bool valid(const monster* a) const;
     void advance();
 };
@@ -58,10 +58,53 @@ struct area_centre
 
 typedef FixedArray<areaprops, GXM, GYM> propgrid_t;
 
-/// The area center cache. Contains centers of all area effects.
-static vector<area_centre> _agrid_centres;
+typedef FixedArray<uint16_t, GXM, GYM> countgrid_t;
+
+/// The area properties a source can give the cells around it, in the order
+/// of their counts in \ref _agrid_counts.
+static constexpr areaprop _source_props[] =
+{
+    areaprop::silence, areaprop::halo, areaprop::liquified, areaprop::orb,
+    areaprop::umbra, areaprop::quad, areaprop::disjunction,
+};
+static constexpr int NUM_SOURCE_PROPS = ARRAYSZ(_source_props);
+static_assert(NUM_SOURCE_PROPS == 7,
+              "_source_props should list every areaprop");
+
+/// The index of prop in \ref _source_props.
+static constexpr int _source_index(areaprop prop, int i = 0)
+{
+    return i == NUM_SOURCE_PROPS || _source_props[i] == prop
+           ? i : _source_index(prop, i + 1);
+}
+
+/// The area effects centred on one actor, or the player's other area
+/// effects (the orb, quad damage and disjunction).
+struct area_source
+{
+    vector<area_centre> centres;
+    /// The cells covered, with the index of their property in
+    /// \ref _source_props.
+    vector<pair<coord_def, int>> cells;
+
+    bool empty() const { return centres.empty(); }
+    void clear()
+    {
+        centres.clear();
+        cells.clear();
+    }
+};
+
+/// Area sources: the player, then each monster slot, then the player's
+/// other area effects. Walking them in order gives the area centres in the
+/// order a full update finds them.
+static const int PLAYER_AREAS = 0;
+static const int PLAYER_OTHER_AREAS = MAX_MONSTERS + 1;
+static area_source _area_sources[MAX_MONSTERS + 2];
 
 static propgrid_t _agrid; ///< The area grid cache
+/// How many sources give each cell each property.
+static countgrid_t _agrid_counts[NUM_SOURCE_PROPS];
 /// \brief Is the area grid cache up-to-date?
 /// \details If false, each check for area effects that affect a coordinate
 /// would trigger an update of the area grid cache.
@@ -69,14 +112,14 @@ static bool _agrid_valid = false;
 /// \brief If true, the level has no area effect
 static bool no_areas = false;
 
-static void _set_agrid_flag(const coord_def& p, areaprop f)
+static bool _check_agrid_flag(const coord_def& p, areaprop f)
 {
-    _agrid(p) |= f;
+    return bool(_agrid(p) & f);
 }
 
-static bool _check_agrid_flag(const coord_def& p, areaprop f)
+static int _area_slot(const actor *act)
 {
-    return bool(_agrid(p) & f);
+    return act->is_player() ? PLAYER_AREAS : act->mindex() + 1;
 }
 
 /// \brief Invalidates the area effect cache
@@ -91,143 +134,257 @@ void invalidate_agrid(bool recheck_new)
         no_areas = false;
 }
 
-void areas_actor_moved(const actor* act, const coord_def& oldpos)
-{
-    UNUSED(oldpos);
-    if (act->alive() &&
-        (you.entering_level
-         || act->halo_radius() > -1 || act->silence_radius() > -1
-         || act->liquefying_radius() > -1 || act->umbra_radius() > -1
-         || act->demon_silence_radius() > -1))
-    {
-        // Not necessarily new, but certainly potentially interesting.
-        invalidate_agrid(true);
-    }
-}
-
-/// \brief Add some of the actor's area effects to the grid and center caches
+/// \brief Find the area effects centred on an actor
 /// \param actor The actor
-/// \details Adds some but not all of an actor's area effects (e.g. silence)
-/// to the area grid (\ref _agrid) and center (\ref _agrid_centres) caches.
-/// Sets \ref no_areas to false if the actor generates those area effects.
-static void _actor_areas(actor *a)
+/// \param src   The source to fill in.
+/// \details Finds some but not all of an actor's area effects (e.g.
+/// silence).
+static void _actor_areas(const actor *a, area_source &src)
 {
     int r;
 
     if ((r = a->silence_radius()) >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::silence, a->pos(), r);
+        src.centres.emplace_back(area_centre_type::silence, a->pos(), r);
 
         for (radius_iterator ri(a->pos(), r, C_SQUARE); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::silence);
-        no_areas = false;
+            src.cells.emplace_back(*ri, _source_index(areaprop::silence));
     }
 
     if ((r = a->demon_silence_radius()) >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::silence, a->pos(), r);
+        src.centres.emplace_back(area_centre_type::silence, a->pos(), r);
 
         for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_DEFAULT, true); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::silence);
-        no_areas = false;
+            src.cells.emplace_back(*ri, _source_index(areaprop::silence));
     }
 
     if ((r = a->halo_radius()) >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::halo, a->pos(), r);
+        src.centres.emplace_back(area_centre_type::halo, a->pos(), r);
 
         for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::halo);
-        no_areas = false;
+            src.cells.emplace_back(*ri, _source_index(areaprop::halo));
     }
 
     if ((r = a->liquefying_radius()) >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::liquid, a->pos(), r);
+        src.centres.emplace_back(area_centre_type::liquid, a->pos(), r);
 
         for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_SOLID); ri; ++ri)
         {
             dungeon_feature_type f = env.grid(*ri);
 
             if (feat_has_solid_floor(f) && !feat_is_water(f))
-                _set_agrid_flag(*ri, areaprop::liquified);
+            {
+                src.cells.emplace_back(*ri,
+                                       _source_index(areaprop::liquified));
+            }
         }
-        no_areas = false;
     }
 
     if ((r = a->umbra_radius()) >= 0)
     {
-        _agrid_centres.emplace_back(area_centre_type::umbra, a->pos(), r);
+        src.centres.emplace_back(area_centre_type::umbra, a->pos(), r);
 
         for (radius_iterator ri(a->pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::umbra);
-        no_areas = false;
+            src.cells.emplace_back(*ri, _source_index(areaprop::umbra));
     }
 }
 
-/**
- * Update the area grid cache.
- *
- * Updates the _agrid FixedArray of grid information flags using the
- * areaprop types.
- */
-static void _update_agrid()
+/// Find the player's area effects that don't come from _actor_areas().
+static void _player_other_areas(area_source &src)
 {
-    // sanitize rng in case this gets indirectly called by the builder.
-    rng::generator gameplay(rng::GAMEPLAY);
-
-    if (no_areas)
-    {
-        _agrid_valid = true;
-        return;
-    }
-
-    _agrid.init(areaprops());
-    _agrid_centres.clear();
-
-    no_areas = true;
-
-    _actor_areas(&you);
-    for (monster_iterator mi; mi; ++mi)
-        _actor_areas(*mi);
-
     if ((player_has_orb() || player_equip_unrand(UNRAND_CHARLATANS_ORB))
          && !you.pos().origin())
     {
         const int r = 2;
-        _agrid_centres.emplace_back(area_centre_type::orb, you.pos(), r);
+        src.centres.emplace_back(area_centre_type::orb, you.pos(), r);
         for (radius_iterator ri(you.pos(), r, C_SQUARE, LOS_DEFAULT); ri; ++ri)
-            _set_agrid_flag(*ri, areaprop::orb);
-        no_areas = false;
+            src.cells.emplace_back(*ri, _source_index(areaprop::orb));
     }
 
     if (you.duration[DUR_QUAD_DAMAGE])
     {
         const int r = 2;
-        _agrid_centres.emplace_back(area_centre_type::quad, you.pos(), r);
+        src.centres.emplace_back(area_centre_type::quad, you.pos(), r);
         for (radius_iterator ri(you.pos(), r, C_SQUARE);
              ri; ++ri)
         {
             if (cell_see_cell(you.pos(), *ri, LOS_DEFAULT))
-                _set_agrid_flag(*ri, areaprop::quad);
+                src.cells.emplace_back(*ri, _source_index(areaprop::quad));
         }
-        no_areas = false;
     }
 
     if (you.duration[DUR_DISJUNCTION])
     {
         const int r = 4;
-        _agrid_centres.emplace_back(area_centre_type::disjunction,
-                                    you.pos(), r);
+        src.centres.emplace_back(area_centre_type::disjunction,
+                                 you.pos(), r);
         for (radius_iterator ri(you.pos(), r, C_SQUARE);
              ri; ++ri)
         {
             if (cell_see_cell(you.pos(), *ri, LOS_DEFAULT))
-                _set_agrid_flag(*ri, areaprop::disjunction);
+            {
+                src.cells.emplace_back(*ri,
+                                       _source_index(areaprop::disjunction));
+            }
         }
+    }
+}
+
+/// Add a source's cells to the grid. A cell has a property while any source
+/// gives it that property.
+static void _add_area_source(const area_source &src)
+{
+    for (const auto &cell : src.cells)
+        if (!_agrid_counts[cell.second](cell.first)++)
+            _agrid(cell.first) |= _source_props[cell.second];
+
+    if (!src.empty())
         no_areas = false;
+}
+
+static void _remove_area_source(const area_source &src)
+{
+    for (const auto &cell : src.cells)
+    {
+        uint16_t &count = _agrid_counts[cell.second](cell.first);
+        ASSERT(count);
+        if (!--count)
+            _agrid(cell.first) &= ~areaprops(_source_props[cell.second]);
+    }
+}
+
+#ifdef DEBUG_AGRID
+/// Check the grid against one built from scratch. This also catches area
+/// changes that forgot to call invalidate_agrid(), so it's not on by default.
+static void _check_agrid()
+{
+    propgrid_t full;
+    full.init(areaprops());
+
+    area_source src;
+    auto add = [&full](const area_source &s)
+    {
+        for (const auto &cell : s.cells)
+            full(cell.first) |= _source_props[cell.second];
+    };
+
+    _actor_areas(&you, src);
+    add(src);
+    for (monster_iterator mi; mi; ++mi)
+    {
+        src.clear();
+        _actor_areas(*mi, src);
+        add(src);
+    }
+    src.clear();
+    _player_other_areas(src);
+    add(src);
+
+    for (rectangle_iterator ri(0); ri; ++ri)
+    {
+        ASSERTM(_agrid(*ri) == full(*ri),
+                "area grid at (%d,%d) is %x, should be %x", ri->x, ri->y,
+                unsigned(_agrid(*ri).flags), unsigned(full(*ri).flags));
+    }
+}
+#endif
+
+/// Update one actor's area effects after it has moved.
+static void _update_actor_areas(const actor *act)
+{
+    // sanitize rng in case this gets indirectly called by the builder.
+    rng::generator gameplay(rng::GAMEPLAY);
+
+    area_source &src = _area_sources[_area_slot(act)];
+    _remove_area_source(src);
+    src.clear();
+    if (act->alive())
+        _actor_areas(act, src);
+    _add_area_source(src);
+
+    if (act->is_player())
+    {
+        area_source &other = _area_sources[PLAYER_OTHER_AREAS];
+        _remove_area_source(other);
+        other.clear();
+        _player_other_areas(other);
+        _add_area_source(other);
+    }
+
+#ifdef DEBUG_AGRID
+    _check_agrid();
+#endif
+}
+
+void areas_actor_moved(const actor* act, const coord_def& oldpos)
+{
+    UNUSED(oldpos);
+    if (you.entering_level)
+    {
+        if (act->alive())
+            invalidate_agrid(true);
+        return;
+    }
+
+    const bool has_areas = act->alive()
+        && (act->halo_radius() > -1 || act->silence_radius() > -1
+            || act->liquefying_radius() > -1 || act->umbra_radius() > -1
+            || act->demon_silence_radius() > -1);
+
+    // Until the grid is next updated in full, only note that there's
+    // something to find.
+    if (!_agrid_valid)
+    {
+        if (has_areas)
+            invalidate_agrid(true);
+        return;
     }
 
+    // Only this actor's areas (and, for the player, the orb etc.) have
+    // moved, so move just those.
+    if (has_areas || !_area_sources[_area_slot(act)].empty()
+        || act->is_player() && !_area_sources[PLAYER_OTHER_AREAS].empty())
+    {
+        _update_actor_areas(act);
+    }
+}
+
+/**
+ * Update the area grid cache.
+ *
+ * Rebuilds the _agrid FixedArray of grid information flags using the
+ * areaprop types, and the counts and sources behind it, from scratch.
+ */
+static void _update_agrid()
+{
+    // sanitize rng in case this gets indirectly called by the builder.
+    rng::generator gameplay(rng::GAMEPLAY);
+
+    if (no_areas)
+    {
+        _agrid_valid = true;
+        return;
+    }
+
+    _agrid.init(areaprops());
+    for (countgrid_t &counts : _agrid_counts)
+        counts.init(0);
+    for (area_source &src : _area_sources)
+        src.clear();
+
+    no_areas = true;
+
+    _actor_areas(&you, _area_sources[PLAYER_AREAS]);
+    for (monster_iterator mi; mi; ++mi)
+        _actor_areas(*mi, _area_sources[_area_slot(*mi)]);
+    _player_other_areas(_area_sources[PLAYER_OTHER_AREAS]);
+
+    for (const area_source &src : _area_sources)
+        _add_area_source(src);
+
     // TODO: update sanctuary here.
 
     _agrid_valid = true;
@@ -259,9 +416,6 @@ coord_def find_centre_for(const coord_def& f, area_centre_type at)
     if (!_agrid(f))
         return coord_def(-1, -1);
 
-    if (_agrid_centres.empty())
-        return coord_def(-1, -1);
-
     coord_def possible = coord_def(-1, -1);
     int dist = 0;
 
@@ -273,19 +427,22 @@ coord_def find_centre_for(const coord_def& f, area_centre_type at)
     // on the off chance that there is an error, assert here
     ASSERT(at != area_centre_type::none);
 
-    for (const area_centre &a : _agrid_centres)
+    for (const area_source &src : _area_sources)
     {
-        if (a.type != at)
-            continue;
+        for (const area_centre &a : src.centres)
+        {
+            if (a.type != at)
+                continue;
 
-        if (a.centre == f)
-            return f;
+            if (a.centre == f)
+                return f;
 
-        int d = grid_distance(a.centre, f);
-        if (d <= a.radius && (d <= dist || dist == 0))
-        {
-            possible = a.centre;
-            dist = d;
+            int d = grid_distance(a.centre, f);
+            if (d <= a.radius && (d <= dist || dist == 0))
+            {
+                possible = a.centre;
+                dist = d;
+            }
         }
     }
 
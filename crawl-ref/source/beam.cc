@@ -1212,7 +1212,11 @@ void bolt::fire()
         _undo_tracer(*this, boltcopy);
     }
     else
+    {
         do_fire();
+        // Whatever the beam did may change what later tracers find.
+        clear_tracer_cache();
+    }
 
     //XXX: suspect, but code relies on path_taken being non-empty
     if (path_taken.empty())
@@ -1903,11 +1907,8 @@ spret mass_enchantment(enchant_type wh_enchant, int pow, bool fail)
 
     pow = min(pow, 200);
 
-    for (monster_iterator mi; mi; ++mi)
+    for (monster_near_iterator mi(you.pos(), LOS_NO_TRANS); mi; ++mi)
     {
-        if (!you.see_cell_no_trans(mi->pos()))
-            continue;
-
         if (mi->has_ench(wh_enchant))
             continue;
 
@@ -2182,6 +2183,109 @@ int silver_damages_victim(actor* victim, int damage, string &dmg_msg)
 //
 //  Note that beam properties must be set, as the tracer will take them
 //  into account, as well as the monster's intelligence.
+// Monster tracer cache
+//
+// During a monster's turn the AI often traces the same beam more than once,
+// e.g. once to decide on a spell or missile and again when using it. Until
+// something moves or a real beam is fired, the same tracer gives the same
+// answer, so keep the traced bolts around for the rest of the turn. Tracers
+// that use the RNG (fuzzing at an unseen target, random flavours) aren't
+// kept, so that the cache never changes what the RNG produces.
+
+struct traced_bolt
+{
+    bolt_tracer_key key; ///< The bolt as fire_tracer() was about to fire it.
+    bool explode_only;
+    bool explosion_hole;
+    bolt result;  ///< The same bolt after tracing.
+};
+
+static const size_t MAX_CACHED_TRACERS = 16;
+static vector<traced_bolt> _tracer_cache;
+static tracer_cache_stats _tracer_stats;
+#ifdef DEBUG_TRACER_CACHE
+static bool _check_tracer_cache = true;
+#else
+static bool _check_tracer_cache = false;
+#endif
+
+// Give a bolt what tracing the same bolt earlier worked out, leaving
+// everything else the caller set alone.
+static void _copy_tracer_result(bolt &pbolt, const bolt &traced)
+{
+    pbolt.foe_info             = traced.foe_info;
+    pbolt.friend_info          = traced.friend_info;
+    pbolt.path_taken           = traced.path_taken;
+    pbolt.hit_count            = traced.hit_count;
+    pbolt.target               = traced.target;
+    pbolt.ray                  = traced.ray;
+    pbolt.extra_range_used     = traced.extra_range_used;
+    pbolt.passed_target        = traced.passed_target;
+    pbolt.friendly_past_target = traced.friendly_past_target;
+    pbolt.bounces              = traced.bounces;
+    pbolt.bounce_pos           = traced.bounce_pos;
+    pbolt.reflections          = traced.reflections;
+    pbolt.reflector            = traced.reflector;
+}
+
+// Can a tracer for this bolt be kept at all?
+static bool _cacheable_tracer(const bolt &pbolt)
+{
+    // The explosion is pointed to, not copied, and a chosen ray isn't
+    // comparable.
+    return !pbolt.special_explosion && !pbolt.chose_ray;
+}
+
+static const traced_bolt *_find_cached_tracer(const bolt_tracer_key &key,
+                                              bool explode_only,
+                                              bool explosion_hole)
+{
+    for (const traced_bolt &traced : _tracer_cache)
+    {
+        if (traced.explode_only == explode_only
+            && traced.explosion_hole == explosion_hole
+            && traced.key == key)
+        {
+            return &traced;
+        }
+    }
+    return nullptr;
+}
+
+/// Forget all traced bolts, e.g. because an actor has moved.
+void clear_tracer_cache()
+{
+    _tracer_cache.clear();
+}
+
+/// Start counting tracers for a new monster turn.
+void tracer_cache_new_turn()
+{
+    clear_tracer_cache();
+    _tracer_stats.monster_turns++;
+    _tracer_stats.turn_calls = 0;
+}
+
+const tracer_cache_stats &tracer_stats()
+{
+    return _tracer_stats;
+}
+
+/// Check each tracer answered from the cache against a freshly fired one
+/// (always on with DEBUG_TRACER_CACHE).
+void check_tracer_cache(bool check)
+{
+    _check_tracer_cache = check;
+}
+
+static void _fire_tracer(bolt &pbolt, bool explode_only, bool explosion_hole)
+{
+    if (explode_only)
+        pbolt.explode(false, explosion_hole);
+    else
+        pbolt.fire();
+}
+
 void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
                  bool explosion_hole)
 {
@@ -2217,11 +2321,62 @@ void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
 
     pbolt.in_explosion_phase = false;
 
-    // Fire!
-    if (explode_only)
-        pbolt.explode(false, explosion_hole);
+    _tracer_stats.calls++;
+    _tracer_stats.turn_calls++;
+    _tracer_stats.max_turn_calls = max(_tracer_stats.max_turn_calls,
+                                       _tracer_stats.turn_calls);
+
+    const bool cacheable = _cacheable_tracer(pbolt);
+    const bolt_tracer_key key = cacheable ? pbolt.tracer_key()
+                                          : bolt_tracer_key();
+    const traced_bolt *cached = cacheable
+        ? _find_cached_tracer(key, explode_only, explosion_hole)
+        : nullptr;
+
+    if (cached)
+    {
+        _tracer_stats.cached++;
+        if (_check_tracer_cache)
+        {
+            bolt check = pbolt;
+            {
+                rng::subgenerator check_rng(0, 0);
+                _fire_tracer(check, explode_only, explosion_hole);
+            }
+            const bolt &res = cached->result;
+            const bool stale = check.foe_info.count != res.foe_info.count
+                || check.foe_info.power != res.foe_info.power
+                || check.friend_info.count != res.friend_info.count
+                || check.friend_info.power != res.friend_info.power
+                || check.path_taken != res.path_taken
+                || check.target != res.target;
+            if (stale)
+                _tracer_stats.stale++;
+#ifdef DEBUG_TRACER_CACHE
+            ASSERTM(!stale, "stale tracer for %s from %s", pbolt.name.c_str(),
+                    mons->name(DESC_PLAIN, true).c_str());
+#endif
+        }
+        _copy_tracer_result(pbolt, cached->result);
+    }
+    else if (cacheable)
+    {
+        traced_bolt traced = { key, explode_only, explosion_hole, bolt() };
+
+        // Fire!
+        const uint64_t rng_state = rng::peek_uint64();
+        _fire_tracer(pbolt, explode_only, explosion_hole);
+
+        if (rng::peek_uint64() == rng_state)
+        {
+            traced.result = pbolt;
+            if (_tracer_cache.size() >= MAX_CACHED_TRACERS)
+                _tracer_cache.erase(_tracer_cache.begin());
+            _tracer_cache.push_back(move(traced));
+        }
+    }
     else
-        pbolt.fire();
+        _fire_tracer(pbolt, explode_only, explosion_hole);
 
     // Unset tracer flag (convenience).
     pbolt.is_tracer = false;
@@ -6991,6 +7146,9 @@ bool bolt::explode(bool show_more, bool hole_in_the_middle)
     else
         real_flavour = flavour;
 
+    if (!is_tracer)
+        clear_tracer_cache();
+
     const int r = min(ex_size, MAX_EXPLOSION_RADIUS);
     in_explosion_phase = true;
     // being hit by bounces doesn't exempt you from the explosion (not that it
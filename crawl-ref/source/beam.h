@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <tuple>
 #include <vector>
 
 #include "ac-type.h"
@@ -19,6 +20,7 @@
 #include "spl-cast.h"
 #include "zap-type.h"
 
+using std::tuple;
 using std::vector;
 
 #define BEAM_STOP       1000        // all beams stopped by subtracting this
@@ -52,6 +54,14 @@ struct tracer_info
     const tracer_info &operator += (const tracer_info &other);
 };
 
+// See bolt::tracer_key().
+typedef tuple<coord_def, coord_def, int, int, int, bool, bool, bool, bool,
+              bool, bool, mid_t, mon_attitude_type, killer_type, int,
+              spell_type, beam_type, beam_type, int, int, int, int, ac_type,
+              string, const item_def*, const item_def*,
+              bool, bool, bool, bool, bool, bool, bool,
+              bool, bool, bool> bolt_tracer_key;
+
 struct bolt
 {
     bolt();
@@ -186,6 +196,29 @@ public:
     void setup_retrace();
     void precalc_agent_properties();
 
+    // What decides the result of a monster tracer: where the beam goes, who
+    // fires it, what it does to whatever it meets, and what its agent can
+    // see. Tracing two bolts with the same key on an unchanged level gives
+    // the same result (see fire_tracer()). Messages and drawing options
+    // aren't part of it, as tracers neither print nor draw.
+    bolt_tracer_key tracer_key() const
+    {
+        return bolt_tracer_key(
+            // Where it goes.
+            source, target, range, extra_range_used, ex_size, aimed_at_spot,
+            aimed_at_feet, pierce, is_explosion, passed_target,
+            use_target_as_pos,
+            // Who fires it.
+            source_id, attitude, thrower, foe_ratio,
+            // What it does.
+            origin_spell, flavour, real_flavour, damage.num, damage.size,
+            ench_power, hit, ac_rule, name, item, launcher,
+            drop_item, item_mulches, was_missile, is_death_effect,
+            affects_nothing, no_saving_throw, effect_known,
+            // What its agent can see.
+            can_see_invis, nightvision, can_trigger_bullseye);
+    }
+
     // Returns YOU_KILL or MON_KILL, depending on the source of the beam.
     killer_type  killer() const;
 
@@ -353,6 +386,22 @@ bool curare_actor(actor* source, actor* target, string name,
 int silver_damages_victim(actor* victim, int damage, string &dmg_msg);
 void fire_tracer(const monster* mons, bolt &pbolt,
                   bool explode_only = false, bool explosion_hole = false);
+
+/// Counts of monster tracers, for checking how well the tracer cache works.
+struct tracer_cache_stats
+{
+    int monster_turns = 0;  ///< Monster turns started.
+    int calls = 0;          ///< Monster tracers fired.
+    int cached = 0;         ///< ... of which were answered from the cache.
+    int stale = 0;          ///< ... and found wrong by check_tracer_cache().
+    int turn_calls = 0;     ///< Tracers fired in the current monster turn.
+    int max_turn_calls = 0; ///< The most tracers fired in one monster turn.
+};
+
+void clear_tracer_cache();
+void tracer_cache_new_turn();
+const tracer_cache_stats &tracer_stats();
+void check_tracer_cache(bool check);
 spret zapping(zap_type ztype, int power, bolt &pbolt,
                    bool needs_tracer = false, const char* msg = nullptr,
                    bool fail = false);
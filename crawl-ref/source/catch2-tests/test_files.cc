@@ -3,7 +3,9 @@
 #include "AppHdr.h"
 
 #include "files.h"
+#include "package.h"
 #include "random.h"
+#include "syscalls.h"
 #include "tags.h"
 
 TEST_CASE( "Test save version reading/writing works", "[single-file]" ) {
@@ -100,3 +102,55 @@ TEST_CASE( "Test save version reading/writing works", "[single-file]" ) {
         }
     }
 }
+
+TEST_CASE( "Save chunks read back what was written", "[single-file]" ) {
+    const char *filename = "test-package.tmp";
+    rng::subgenerator subgen(0, 0);
+
+    // Big enough to span several compression buffers.
+    vector<unsigned char> data;
+    for (auto i = 0; i < 200000; i++)
+        data.push_back(i % 7 ? random2(4) : random2(256));
+
+    {
+        package save(filename, true, true);
+        writer w(&save, "big");
+        for (size_t i = 0; i < data.size(); i += 1000)
+            w.write(&data[i], min<size_t>(1000, data.size() - i));
+        writer(&save, "empty");
+    }
+
+    {
+        package save(filename, false);
+
+        SECTION ("through a reader") {
+            reader r(&save, "big");
+            vector<unsigned char> read(data.size());
+            r.read(&read[0], read.size());
+
+            REQUIRE(read == data);
+            REQUIRE(r.valid() == false);
+            REQUIRE_NOTHROW(r.fail_if_not_eof("big"));
+        }
+
+        SECTION ("through a chunk_reader in small pieces") {
+            chunk_reader rd(&save, "big");
+            vector<unsigned char> read(data.size() + 1);
+            size_t at = 0;
+            while (plen_t s = rd.read(&read[at], min<size_t>(777,
+                                                             read.size() - at)))
+            {
+                at += s;
+            }
+            read.resize(at);
+
+            REQUIRE(read == data);
+        }
+
+        SECTION ("empty chunks") {
+            reader r(&save, "empty");
+            REQUIRE(r.valid() == false);
+        }
+    }
+    unlink_u(filename);
+}
@@ -0,0 +1,159 @@
+#include "catch_amalgamated.hpp"
+
+#include "AppHdr.h"
+
+#include "store.h"
+#include "stringutil.h"
+#include "tags.h"
+
+TEST_CASE( "CrawlHashTable keeps its entries in key order", "[single-file]" ) {
+    CrawlHashTable table;
+    table["gamma"] = 3;
+    table["alpha"] = 1;
+    table["beta"] = 2;
+
+    vector<string> keys;
+    for (const auto &entry : table)
+        keys.push_back(entry.first);
+    REQUIRE(keys == vector<string>({ "alpha", "beta", "gamma" }));
+
+    REQUIRE(table.size() == 3);
+    REQUIRE(table.exists("beta"));
+    REQUIRE(table.exists(string("gamma")));
+    REQUIRE_FALSE(table.exists("delta"));
+    REQUIRE(table.count("alpha") == 1);
+    REQUIRE(table.find("delta") == table.end());
+    REQUIRE(table.find("beta")->second.get_int() == 2);
+
+    const CrawlHashTable &ctable = table;
+    REQUIRE(ctable["gamma"].get_int() == 3);
+}
+
+TEST_CASE( "CrawlHashTable erases entries", "[single-file]" ) {
+    CrawlHashTable table;
+    table["a"] = 1;
+    table["b"] = 2;
+    table["c"] = 3;
+
+    REQUIRE(table.erase("b") == 1);
+    REQUIRE(table.erase("b") == 0);
+    REQUIRE_FALSE(table.exists("b"));
+    REQUIRE(table.size() == 2);
+
+    auto it = table.erase(table.find("a"));
+    REQUIRE(it->first == "c");
+
+    table.clear();
+    REQUIRE(table.empty());
+    REQUIRE_FALSE(table.exists("c"));
+}
+
+TEST_CASE( "CrawlHashTable values don't move when keys are added",
+           "[single-file]" ) {
+    CrawlHashTable table;
+    CrawlStoreValue &first = table["m"];
+    first = 7;
+    for (int i = 0; i < 100; i++)
+        table[make_stringf("key %d", i)] = i;
+    table.erase("key 50");
+
+    REQUIRE(&table["m"] == &first);
+    REQUIRE(first.get_int() == 7);
+}
+
+TEST_CASE( "CrawlHashTable copies are deep", "[single-file]" ) {
+    CrawlHashTable table;
+    table["nested"].get_table()["x"] = 1;
+
+    CrawlHashTable copy = table;
+    copy["nested"].get_table()["x"] = 2;
+    copy["extra"] = true;
+
+    REQUIRE(table["nested"].get_table()["x"].get_int() == 1);
+    REQUIRE_FALSE(table.exists("extra"));
+    REQUIRE(copy.size() == 2);
+}
+
+TEST_CASE( "CrawlHashTable save format is unchanged", "[single-file]" ) {
+    CrawlHashTable table;
+    table["zeta"] = true;
+    table["alpha"] = 5;
+
+    vector<unsigned char> expected;
+    {
+        writer w(&expected);
+        marshallUnsigned(w, 2);
+        marshallString(w, "alpha");
+        marshallByte(w, SV_INT);
+        marshallByte(w, 0);
+        marshallInt(w, 5);
+        marshallString(w, "zeta");
+        marshallByte(w, SV_BOOL);
+        marshallByte(w, 0);
+        marshallBoolean(w, true);
+    }
+
+    vector<unsigned char> saved;
+    writer w(&saved);
+    table.write(w);
+    REQUIRE(saved == expected);
+
+    reader r(saved, TAG_MINOR_VERSION);
+    CrawlHashTable loaded;
+    loaded.read(r);
+    REQUIRE(loaded.size() == 2);
+    REQUIRE(loaded["alpha"].get_int() == 5);
+    REQUIRE(loaded["zeta"].get_bool());
+}
+
+// Roughly the property lookups of a turn: mostly failed exists() checks on
+// small monster tables, with some on a large player-sized one. Compare with
+// the std::map the table used to be. Run with
+//   ./catch2-tests-executable "[benchmark]"
+TEST_CASE( "CrawlHashTable lookup benchmark", "[.][benchmark]" ) {
+    const vector<const char *> lookups = {
+        "summon_type", "mon_swapped", "chaos_shift_time", "berserk_mult",
+        "kraken_tentacle", "ideal_range", "polymorph_tier",
+        "foe_memory", "monster_tile", "dbname", "mon_gender",
+        "known_spells", "speed_mult", "original_name", "item_tile",
+    };
+
+    CrawlHashTable mon;
+    map<string, CrawlStoreValue> mon_map;
+    for (const char *key : { "dbname", "mon_gender", "ideal_range",
+                             "monster_tile", "foe_memory" })
+    {
+        mon[key] = 1;
+        mon_map[key] = 1;
+    }
+
+    CrawlHashTable you;
+    map<string, CrawlStoreValue> you_map;
+    vector<string> you_keys;
+    for (int i = 0; i < 150; i++)
+    {
+        you_keys.push_back(make_stringf("player_prop_%d", i));
+        you[you_keys.back()] = i;
+        you_map[you_keys.back()] = i;
+    }
+
+    BENCHMARK("CrawlHashTable") {
+        int found = 0;
+        for (int i = 0; i < 40; i++)
+            for (const char *key : lookups)
+                found += mon.exists(key);
+        for (int i = 0; i < 100; i++)
+            found += you.exists(you_keys[i]);
+        return found;
+    };
+
+    BENCHMARK("std::map") {
+        int found = 0;
+        for (int i = 0; i < 40; i++)
+            for (const char *key : lookups)
+                found += mon_map.find(key) != mon_map.end();
+        for (int i = 0; i < 100; i++)
+            found += you_map.find(you_keys[i]) != you_map.end();
+        return found;
+    };
+}
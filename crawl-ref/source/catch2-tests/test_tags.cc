@@ -4,9 +4,12 @@
 
 #include "AppHdr.h"
 
+#include "env.h"
+#include "externs.h"
 #include "map-cell.h"
 #include "random.h"
 #include "tags.h"
+#include "tile-env.h"
 
 TEST_CASE( "Vehumet gifts can be decoded", "[single-file]" ) {
 
@@ -245,3 +248,212 @@ TEST_CASE( "Basic marshalling/unmarshalling works correctly.", "[single-file]" )
         }
     }
 }
+
+template<typename T, int WIDTH, int HEIGHT>
+static bool _grids_equal(const FixedArray<T, WIDTH, HEIGHT> &a,
+                         const FixedArray<T, WIDTH, HEIGHT> &b)
+{
+    for (int x = 0; x < WIDTH; x++)
+        for (int y = 0; y < HEIGHT; y++)
+            if (a[x][y] != b[x][y])
+                return false;
+    return true;
+}
+
+TEST_CASE( "Level grids can be marshalled column by column", "[single-file]" ) {
+
+    SECTION ("runs and differences are packed into single varints") {
+        FixedArray<int, 2, 3> grid;
+        grid[0][0] = 5; grid[0][1] = 5; grid[0][2] = 5;
+        grid[1][0] = 5; grid[1][1] = 4; grid[1][2] = 4;
+
+        vector<unsigned char> buf;
+        auto w = writer(&buf);
+        marshall_grid(w, grid);
+
+        const vector<unsigned char> expected = {
+            0x20, // run of 3, +5 from 0: 10 * 3 + 2
+            0x00, // run of 1, +0 from 5: 0 * 3 + 0
+            0x04, // run of 2, -1 from 5: 1 * 3 + 1
+        };
+        REQUIRE(buf == expected);
+
+        FixedArray<int, 2, 3> roundtrip_grid(0);
+        auto r = reader(buf);
+        unmarshall_grid(r, roundtrip_grid);
+
+        REQUIRE(_grids_equal(roundtrip_grid, grid));
+        REQUIRE(r.valid() == false);
+    }
+
+    SECTION ("any values can be roundtripped") {
+        FixedArray<int32_t, GXM, GYM> grid;
+        random_device rd;
+        mt19937 generator(rd());
+        uniform_int_distribution<int32_t> distribution(INT32_MIN, INT32_MAX);
+        for (int x = 0; x < GXM; x++)
+            for (int y = 0; y < GYM; y++)
+                grid[x][y] = distribution(generator);
+        grid[0][0] = INT32_MIN;
+        grid[0][1] = INT32_MAX;
+        grid[0][2] = INT32_MIN;
+
+        vector<unsigned char> buf;
+        auto w = writer(&buf);
+        marshall_grid(w, grid);
+
+        FixedArray<int32_t, GXM, GYM> roundtrip_grid(0);
+        auto r = reader(buf);
+        unmarshall_grid(r, roundtrip_grid);
+
+        REQUIRE(_grids_equal(roundtrip_grid, grid));
+        REQUIRE(r.valid() == false);
+    }
+
+    SECTION ("terrain takes less room than a byte per cell") {
+        feature_grid grid(DNGN_ROCK_WALL);
+        for (int x = 1; x < GXM - 1; x++)
+            for (int y = 1; y < GYM - 1; y++)
+                grid[x][y] = x % 8 && y % 6 ? DNGN_FLOOR : DNGN_STONE_WALL;
+
+        vector<unsigned char> buf;
+        auto w = writer(&buf);
+        marshall_grid(w, grid);
+
+        REQUIRE(buf.size() < (size_t)(GXM * GYM));
+
+        feature_grid roundtrip_grid(DNGN_UNSEEN);
+        auto r = reader(buf);
+        unmarshall_grid(r, roundtrip_grid);
+
+        REQUIRE(_grids_equal(roundtrip_grid, grid));
+        REQUIRE(r.valid() == false);
+    }
+}
+
+#if TAG_MAJOR_VERSION == 34
+static dungeon_feature_type _old_level_feature(int x, int y)
+{
+    const int cell = (x / 7 + y / 5) % 3;
+    return cell == 0 ? DNGN_ROCK_WALL : cell == 1 ? DNGN_FLOOR
+                                                  : DNGN_CLOSED_DOOR;
+}
+
+static uint32_t _old_level_flags(int x, int y)
+{
+    return x % 9 == 0 && y % 4 == 0 ? 0x4 : 0;
+}
+
+static unsigned short _old_level_colour(int x, int y)
+{
+    return x >= 10 && x < 30 && y >= 20 && y < 25 ? 5 : 0;
+}
+
+static unsigned short _old_level_flavour(int x, int y, int field)
+{
+    return (x + 3 * y + field) % (field + 2);
+}
+
+static void _check_old_level(const string &name)
+{
+    INFO(name);
+    for (int x = 0; x < GXM; x++)
+        for (int y = 0; y < GYM; y++)
+        {
+            REQUIRE(env.grid[x][y] == _old_level_feature(x, y));
+            REQUIRE(env.pgrid[x][y].flags == _old_level_flags(x, y));
+            REQUIRE(env.map_knowledge[x][y].flags == (uint32_t)x);
+            REQUIRE(env.grid_colours[x][y] == _old_level_colour(x, y));
+
+            const tile_flavour &flv = tile_env.flv[x][y];
+            REQUIRE(flv.wall_idx == _old_level_flavour(x, y, 0));
+            REQUIRE(flv.floor_idx == _old_level_flavour(x, y, 1));
+            REQUIRE(flv.feat_idx == _old_level_flavour(x, y, 2));
+            REQUIRE(flv.wall == _old_level_flavour(x, y, 3));
+            REQUIRE(flv.floor == _old_level_flavour(x, y, 4));
+            REQUIRE(flv.feat == _old_level_flavour(x, y, 5));
+            REQUIRE(flv.special == _old_level_flavour(x, y, 6));
+        }
+}
+
+static void _clear_level_grids()
+{
+    env.grid.init(DNGN_UNSEEN);
+    for (int x = 0; x < GXM; x++)
+        for (int y = 0; y < GYM; y++)
+        {
+            env.pgrid[x][y].flags = 0;
+            env.map_knowledge[x][y].clear();
+            tile_env.flv[x][y] = tile_flavour();
+        }
+    env.grid_colours.init(7);
+}
+
+TEST_CASE( "Level grids of older saves are converted", "[single-file]" ) {
+
+    void marshallMapCell (writer &, const map_cell &);
+
+    // Lay out the grids the way saves before TAG_MINOR_COLUMN_GRIDS did.
+    vector<unsigned char> buf;
+    auto w = writer(&buf);
+    for (int x = 0; x < GXM; x++)
+        for (int y = 0; y < GYM; y++)
+        {
+            marshallUByte(w, _old_level_feature(x, y));
+            map_cell cell;
+            cell.flags = x;
+            marshallMapCell(w, cell);
+            marshallInt(w, _old_level_flags(x, y));
+        }
+
+    // Colours were run-length encoded row by row, in runs of at most 255.
+    int run = 0;
+    unsigned short last = 0;
+    for (int y = 0; y < GYM; y++)
+        for (int x = 0; x < GXM; x++)
+        {
+            const unsigned short colour = _old_level_colour(x, y);
+            if (run && (colour != last || run == 255))
+            {
+                marshallByte(w, run);
+                marshallByte(w, last);
+                run = 0;
+            }
+            last = colour;
+            run++;
+        }
+    marshallByte(w, run);
+    marshallByte(w, last);
+
+    for (int x = 0; x < GXM; x++)
+        for (int y = 0; y < GYM; y++)
+            for (int field = 0; field < 7; field++)
+                marshallShort(w, _old_level_flavour(x, y, field));
+
+    _clear_level_grids();
+    auto r = reader(buf);
+    r.setMinorVersion(TAG_MINOR_COLUMN_GRIDS - 1);
+    unmarshall_level_grids(r);
+    unmarshall_level_colours(r);
+    unmarshall_tile_flavours(r);
+    REQUIRE(r.valid() == false);
+    _check_old_level("old layout");
+
+    // Saving again writes the column layout, which reads back the same.
+    vector<unsigned char> new_buf;
+    auto new_w = writer(&new_buf);
+    marshall_level_grids(new_w);
+    marshall_level_colours(new_w);
+    marshall_tile_flavours(new_w);
+    REQUIRE(new_buf.size() < buf.size());
+
+    _clear_level_grids();
+    auto new_r = reader(new_buf);
+    new_r.setMinorVersion(TAG_MINOR_VERSION);
+    unmarshall_level_grids(new_r);
+    unmarshall_level_colours(new_r);
+    unmarshall_tile_flavours(new_r);
+    REQUIRE(new_r.valid() == false);
+    _check_old_level("column layout");
+}
+#endif
@@ -25,6 +25,19 @@ function test.map_assert(condition, message)
   return condition
 end
 
+-- Both losight() engines must agree bit for bit on what (x, y) sees.
+function test.check_los_engines(x, y, failmap, iter)
+  local ok, fx, fy = los.check_engines(x, y)
+  if not ok then
+    dgn.fprop_changed(fx, fy, "highlight")
+    debug.dump_map(failmap)
+    assert(false,
+           "LOS engines disagree (iter #" .. iter .. "): from "
+             .. dgn.point(x, y) .. " about " .. dgn.point(fx, fy) .. "."
+             .. " Map saved to " .. failmap)
+  end
+end
+
 function test.place_items_at(point, item_spec)
   dgn.create_item(point.x, point.y, item_spec)
   return dgn.items_at(point.x, point.y)
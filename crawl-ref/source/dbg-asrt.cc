@@ -18,6 +18,7 @@
 #include "directn.h"
 #include "dlua.h"
 #include "env.h"
+#include "errors.h"
 #include "files.h"
 #include "hiscores.h"
 #include "initfile.h"
@@ -791,6 +792,12 @@ void do_crash_dump()
 NORETURN static void _BreakStrToDebugger(const char *mesg, bool assert)
 {
     UNUSED(assert);
+    if (fatal_errors_throw)
+    {
+        _assert_msg.clear();
+        throw fatal_thread_error(mesg);
+    }
+
 // FIXME: this needs a way to get the SDL_window in windowmanager-sdl.cc
 #if 0
 #if defined(USE_TILE_LOCAL) && defined(TARGET_OS_WINDOWS)
@@ -7,6 +7,12 @@
 
 #include "dbg-maps.h"
 
+#include <chrono>
+#ifdef UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "branch.h"
 #include "chardump.h"
 #include "crash.h"
@@ -15,6 +21,8 @@
 #include "env.h"
 #include "initfile.h"
 #include "item-prop.h" // initialise_item_sets
+#include "json.h"
+#include "json-wrapper.h"
 #include "libutil.h"
 #include "maps.h"
 #include "message.h"
@@ -25,6 +33,7 @@
 #include "stringutil.h"
 #include "syscalls.h"
 #include "tag-version.h"
+#include "version.h"
 #include "view.h"
 
 #ifdef DEBUG_STATISTICS
@@ -49,10 +58,98 @@ static int build_attempts = 0, level_vetoes = 0;
 // Map from message to counts.
 static map<string, int> veto_messages;
 
+// One level build timed by -mapstat-bench.
+struct bench_level_record
+{
+    string place;
+    int64_t usec;
+    int attempts;   // builder attempts, including vetoed ones
+    int vetoes;     // dgn_veto_exceptions recorded
+    bool built;
+    string vaults;  // comma-separated names of the vaults placed
+};
+
+static vector<bench_level_record> bench_records;
+
+// Builder time charged to a map or layout type. Each build attempt's wall
+// time is charged to every map it placed and to each of its layout types;
+// the time of vetoed attempts is wasted.
+struct builder_cost
+{
+    int attempts = 0;
+    int vetoes = 0;
+    int64_t usec = 0;
+    int64_t wasted_usec = 0;
+};
+
+static map<string, builder_cost> map_costs;
+static map<string, builder_cost> layout_costs;
+static vector<string> attempt_maps;
+static chrono::steady_clock::time_point attempt_start;
+
+// Random map selections by kind of selector. Candidates are the maps the
+// selection indexes offered, of which the selector accepted some.
+struct selection_cost
+{
+    int selections = 0;
+    int64_t candidates = 0;
+    int64_t accepted = 0;
+    int64_t usec = 0;
+};
+
+static map<string, selection_cost> selection_costs;
+
 void mapstat_report_map_build_start()
 {
     build_attempts++;
     map_builds[level_id::current()].first++;
+    attempt_maps.clear();
+    attempt_start = chrono::steady_clock::now();
+}
+
+static void _charge_builder_cost(builder_cost &cost, bool success,
+                                 int64_t usec)
+{
+    cost.attempts++;
+    cost.usec += usec;
+    if (!success)
+    {
+        cost.vetoes++;
+        cost.wasted_usec += usec;
+    }
+}
+
+/**
+ * Charge the time of the build attempt that just finished to the maps it
+ * placed and its layout types.
+ *
+ * @param success Whether the attempt produced a level; false for vetoes,
+ *                including failed connectivity checks.
+ * @param layouts The layout types of the attempt.
+ */
+void mapstat_report_map_build_end(bool success, const set<string> &layouts)
+{
+    const int64_t usec = chrono::duration_cast<chrono::microseconds>(
+                            chrono::steady_clock::now() - attempt_start).count();
+    // A map placed twice in one attempt is still charged once.
+    sort(attempt_maps.begin(), attempt_maps.end());
+    attempt_maps.erase(unique(attempt_maps.begin(), attempt_maps.end()),
+                       attempt_maps.end());
+    for (const string &name : attempt_maps)
+        _charge_builder_cost(map_costs[name], success, usec);
+    for (const string &layout : layouts)
+        _charge_builder_cost(layout_costs[layout], success, usec);
+    attempt_maps.clear();
+}
+
+void mapstat_report_map_selection(const char *selector, size_t candidates,
+                                  size_t accepted, int64_t usec)
+{
+    selection_cost &cost = selection_costs[selector];
+    cost.selections++;
+    cost.candidates += candidates;
+    cost.accepted += accepted;
+    cost.usec += usec;
 }
 
 void mapstat_report_map_veto(const string &message)
@@ -95,7 +192,30 @@ static bool _do_build_level()
     }
 
     ++levels_tried;
-    if (!builder())
+    const int attempts_before = build_attempts;
+    const int vetoes_before = level_vetoes;
+    const auto build_start = chrono::steady_clock::now();
+    const bool built = builder();
+    if (crawl_state.map_stat_bench)
+    {
+        bench_level_record rec;
+        rec.place = level_id::current().describe();
+        rec.usec = chrono::duration_cast<chrono::microseconds>(
+                        chrono::steady_clock::now() - build_start).count();
+        rec.attempts = build_attempts - attempts_before;
+        rec.vetoes = level_vetoes - vetoes_before;
+        rec.built = built;
+        if (built)
+        {
+            rec.vaults = comma_separated_fn(
+                begin(env.level_vaults), end(env.level_vaults),
+                [](unique_ptr<vault_placement> &lp) { return lp->map.name; },
+                ",", ",");
+        }
+        bench_records.push_back(rec);
+    }
+
+    if (!built)
     {
         ++levels_failed;
         // Abort level build failure in objstat since the statistics will be
@@ -278,6 +398,7 @@ void mapstat_report_map_try(const map_def &map)
 
 void mapstat_report_map_use(const map_def &map)
 {
+    attempt_maps.push_back(map.name);
     use_count[map.name]++;
     level_mapcounts[level_id::current()]++;
     level_mapsused[level_id::current()].insert(map.name);
@@ -317,6 +438,53 @@ static void _report_available_random_vaults(FILE *outf)
     }
 }
 
+// Sort by wasted builder time, most expensive first.
+static vector<pair<string, builder_cost>>
+_sorted_builder_costs(const map<string, builder_cost> &costs)
+{
+    vector<pair<string, builder_cost>> sorted(costs.begin(), costs.end());
+    stable_sort(sorted.begin(), sorted.end(),
+                [](const pair<string, builder_cost> &a,
+                   const pair<string, builder_cost> &b)
+                { return a.second.wasted_usec > b.second.wasted_usec; });
+    return sorted;
+}
+
+static void _write_builder_costs(FILE *outf, const char *what,
+                                 const map<string, builder_cost> &costs)
+{
+    if (costs.empty())
+        return;
+
+    fprintf(outf, "\n\nBuilder cost by %s (vetoed of attempts, wasted ms, "
+                  "total ms):\n", what);
+    int count = 0;
+    for (const auto &entry : _sorted_builder_costs(costs))
+    {
+        const builder_cost &cost = entry.second;
+        fprintf(outf, "%4d) %5d of %5d, %9.1f, %9.1f: %s\n", ++count,
+                cost.vetoes, cost.attempts, cost.wasted_usec / 1000.0,
+                cost.usec / 1000.0, entry.first.c_str());
+    }
+}
+
+static void _write_selection_costs(FILE *outf)
+{
+    if (selection_costs.empty())
+        return;
+
+    fprintf(outf, "\n\nMap selections of %d maps (selections, candidates, "
+                  "accepted, ms):\n",
+            map_count());
+    for (const auto &entry : selection_costs)
+    {
+        const selection_cost &cost = entry.second;
+        fprintf(outf, "%7d, %9" PRId64 ", %8" PRId64 ", %9.1f: %s\n",
+                cost.selections, cost.candidates, cost.accepted,
+                cost.usec / 1000.0, entry.first.c_str());
+    }
+}
+
 static void _check_mapless(const level_id &lid, vector<level_id> &mapless)
 {
     if (!level_mapsused.count(lid))
@@ -409,6 +577,10 @@ static void _write_map_stats()
             fprintf(outf, "%3d) %s\n", i->first, i->second.c_str());
     }
 
+    _write_builder_costs(outf, "map", map_costs);
+    _write_builder_costs(outf, "layout type", layout_costs);
+    _write_selection_costs(outf);
+
     if (!unused_maps.empty() && !SysEnv.map_gen_range)
     {
         fprintf(outf, "\n\nUnused maps:\n\n");
@@ -500,6 +672,363 @@ bool mapstat_find_forced_map()
     return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// -mapstat-bench: time level generation.
+//
+// Builds -iters dungeons split across -jobs worker processes. Each worker
+// writes its level records and veto counts to a temporary file, which the
+// parent merges into mapstat-bench.json.
+
+static string _bench_worker_file(int worker)
+{
+    return make_stringf("mapstat-bench.%d.tmp", worker);
+}
+
+static string _bench_field(string s)
+{
+    for (char &c : s)
+        if (c == '\t' || c == '\n')
+            c = ' ';
+    return s;
+}
+
+static bool _bench_write_worker_file(int worker)
+{
+    FILE *outf = fopen_u(_bench_worker_file(worker).c_str(), "w");
+    if (!outf)
+        return false;
+    for (const auto &rec : bench_records)
+    {
+        fprintf(outf, "L\t%s\t%" PRId64 "\t%d\t%d\t%d\t%s\n",
+                rec.place.c_str(), rec.usec, rec.attempts, rec.vetoes,
+                rec.built ? 1 : 0, rec.vaults.c_str());
+    }
+    for (const auto &entry : veto_messages)
+    {
+        fprintf(outf, "V\t%d\t%s\n", entry.second,
+                _bench_field(entry.first).c_str());
+    }
+    for (int i = 0; i < 2; ++i)
+        for (const auto &entry : i ? layout_costs : map_costs)
+        {
+            const builder_cost &cost = entry.second;
+            fprintf(outf, "%c\t%s\t%d\t%d\t%" PRId64 "\t%" PRId64 "\n",
+                    i ? 'T' : 'M', entry.first.c_str(), cost.attempts,
+                    cost.vetoes, cost.usec, cost.wasted_usec);
+        }
+    for (const auto &entry : selection_costs)
+    {
+        const selection_cost &cost = entry.second;
+        fprintf(outf, "S\t%s\t%d\t%" PRId64 "\t%" PRId64 "\t%" PRId64 "\n",
+                entry.first.c_str(), cost.selections, cost.candidates,
+                cost.accepted, cost.usec);
+    }
+    fclose(outf);
+    return true;
+}
+
+// Read a whole line, however long, without its newline. "L" records carry
+// the full vault list of a level, which can be longer than any fixed buffer.
+static bool _bench_read_line(FILE *inf, string &line)
+{
+    line.clear();
+    char buf[4096];
+    while (fgets(buf, sizeof(buf), inf))
+    {
+        line += buf;
+        if (line.back() == '\n')
+        {
+            line.pop_back();
+            return true;
+        }
+    }
+    return !line.empty();
+}
+
+static bool _bench_read_worker_file(int worker)
+{
+    const string file = _bench_worker_file(worker);
+    FILE *inf = fopen_u(file.c_str(), "r");
+    if (!inf)
+        return false;
+
+    string line;
+    while (_bench_read_line(inf, line))
+    {
+        const vector<string> f = split_string("\t", line, false, true);
+        if (f.size() == 7 && f[0] == "L")
+        {
+            bench_level_record rec;
+            rec.place = f[1];
+            rec.usec = strtoll(f[2].c_str(), nullptr, 10);
+            rec.attempts = atoi(f[3].c_str());
+            rec.vetoes = atoi(f[4].c_str());
+            rec.built = f[5] == "1";
+            rec.vaults = f[6];
+            bench_records.push_back(rec);
+        }
+        else if (f.size() == 3 && f[0] == "V")
+            veto_messages[f[2]] += atoi(f[1].c_str());
+        else if (f.size() == 6 && (f[0] == "M" || f[0] == "T"))
+        {
+            builder_cost &cost = f[0] == "M" ? map_costs[f[1]]
+                                             : layout_costs[f[1]];
+            cost.attempts += atoi(f[2].c_str());
+            cost.vetoes += atoi(f[3].c_str());
+            cost.usec += strtoll(f[4].c_str(), nullptr, 10);
+            cost.wasted_usec += strtoll(f[5].c_str(), nullptr, 10);
+        }
+        else if (f.size() == 6 && f[0] == "S")
+        {
+            selection_cost &cost = selection_costs[f[1]];
+            cost.selections += atoi(f[2].c_str());
+            cost.candidates += strtoll(f[3].c_str(), nullptr, 10);
+            cost.accepted += strtoll(f[4].c_str(), nullptr, 10);
+            cost.usec += strtoll(f[5].c_str(), nullptr, 10);
+        }
+    }
+    fclose(inf);
+    unlink_u(file.c_str());
+    return true;
+}
+
+// Build this worker's share of the dungeons.
+static bool _bench_run_worker(int worker, int jobs)
+{
+    // Different workers must not build the same dungeons.
+    if (Options.seed)
+        rng::seed(Options.seed + worker);
+    else if (worker)
+        rng::seed();
+
+    const int iters = SysEnv.map_gen_iters;
+    SysEnv.map_gen_iters = iters / jobs + (worker < iters % jobs ? 1 : 0);
+    return !SysEnv.map_gen_iters || mapstat_build_levels();
+}
+
+static JsonNode *_bench_level_json(const string &place,
+                                   const vector<const bench_level_record *>
+                                       &recs)
+{
+    int failed = 0, attempts = 0, vetoes = 0;
+    int64_t total = 0, slowest = 0;
+    for (const auto *rec : recs)
+    {
+        failed += !rec->built;
+        attempts += rec->attempts;
+        vetoes += rec->vetoes;
+        total += rec->usec;
+        slowest = max(slowest, rec->usec);
+    }
+
+    JsonNode *lev(json_mkobject());
+    json_append_member(lev, "place", json_mkstring(place.c_str()));
+    json_append_member(lev, "builds", json_mknumber(recs.size()));
+    json_append_member(lev, "failed", json_mknumber(failed));
+    json_append_member(lev, "attempts", json_mknumber(attempts));
+    json_append_member(lev, "vetoes", json_mknumber(vetoes));
+    json_append_member(lev, "total_ms", json_mknumber(total / 1000.0));
+    json_append_member(lev, "mean_ms",
+                       json_mknumber(total / 1000.0 / recs.size()));
+    json_append_member(lev, "max_ms", json_mknumber(slowest / 1000.0));
+    return lev;
+}
+
+static JsonNode *_builder_costs_json(const map<string, builder_cost> &costs)
+{
+    JsonNode *arr(json_mkarray());
+    for (const auto &entry : _sorted_builder_costs(costs))
+    {
+        const builder_cost &cost = entry.second;
+        JsonNode *node(json_mkobject());
+        json_append_member(node, "name", json_mkstring(entry.first.c_str()));
+        json_append_member(node, "attempts", json_mknumber(cost.attempts));
+        json_append_member(node, "vetoes", json_mknumber(cost.vetoes));
+        json_append_member(node, "total_ms", json_mknumber(cost.usec / 1000.0));
+        json_append_member(node, "wasted_ms",
+                           json_mknumber(cost.wasted_usec / 1000.0));
+        json_append_element(arr, node);
+    }
+    return arr;
+}
+
+static JsonNode *_selection_costs_json()
+{
+    JsonNode *arr(json_mkarray());
+    for (const auto &entry : selection_costs)
+    {
+        const selection_cost &cost = entry.second;
+        JsonNode *node(json_mkobject());
+        json_append_member(node, "selector",
+                           json_mkstring(entry.first.c_str()));
+        json_append_member(node, "selections", json_mknumber(cost.selections));
+        json_append_member(node, "candidates", json_mknumber(cost.candidates));
+        json_append_member(node, "accepted", json_mknumber(cost.accepted));
+        json_append_member(node, "total_ms", json_mknumber(cost.usec / 1000.0));
+        json_append_element(arr, node);
+    }
+    return arr;
+}
+
+static void _write_bench_stats(int jobs, double wall_seconds)
+{
+    int failed = 0, attempts = 0, vetoes = 0;
+    int64_t total = 0;
+    map<string, vector<const bench_level_record *>> by_place;
+    for (const auto &rec : bench_records)
+    {
+        failed += !rec.built;
+        attempts += rec.attempts;
+        vetoes += rec.vetoes;
+        total += rec.usec;
+        by_place[rec.place].push_back(&rec);
+    }
+
+    JsonWrapper json(json_mkobject());
+    json_append_member(json.node, "version", json_mkstring(Version::Long));
+    json_append_member(json.node, "seed",
+                       json_mkstring(to_string(Options.seed).c_str()));
+    json_append_member(json.node, "dungeons",
+                       json_mknumber(SysEnv.map_gen_iters));
+    json_append_member(json.node, "jobs", json_mknumber(jobs));
+    json_append_member(json.node, "wall_seconds", json_mknumber(wall_seconds));
+    json_append_member(json.node, "levels_built",
+                       json_mknumber(bench_records.size() - failed));
+    json_append_member(json.node, "levels_failed", json_mknumber(failed));
+    json_append_member(json.node, "attempts", json_mknumber(attempts));
+    json_append_member(json.node, "vetoes", json_mknumber(vetoes));
+    json_append_member(json.node, "build_seconds",
+                       json_mknumber(total / 1000000.0));
+
+    JsonNode *levels(json_mkarray());
+    for (const level_id &lid : generated_levels)
+    {
+        const string place = lid.describe();
+        if (by_place.count(place))
+            json_append_element(levels, _bench_level_json(place, by_place[place]));
+    }
+    json_append_member(json.node, "levels", levels);
+
+    // The slowest individual builds, with the vaults they placed.
+    vector<const bench_level_record *> slowest;
+    for (const auto &rec : bench_records)
+        slowest.push_back(&rec);
+    sort(slowest.begin(), slowest.end(),
+         [](const bench_level_record *a, const bench_level_record *b)
+         { return a->usec > b->usec; });
+    if (slowest.size() > 50)
+        slowest.resize(50);
+
+    JsonNode *slow(json_mkarray());
+    for (const auto *rec : slowest)
+    {
+        JsonNode *build(json_mkobject());
+        json_append_member(build, "place", json_mkstring(rec->place.c_str()));
+        json_append_member(build, "ms", json_mknumber(rec->usec / 1000.0));
+        json_append_member(build, "attempts", json_mknumber(rec->attempts));
+        json_append_member(build, "vetoes", json_mknumber(rec->vetoes));
+        json_append_member(build, "built", json_mkbool(rec->built));
+        JsonNode *vaults(json_mkarray());
+        for (const string &name : split_string(",", rec->vaults))
+            json_append_element(vaults, json_mkstring(name.c_str()));
+        json_append_member(build, "vaults", vaults);
+        json_append_element(slow, build);
+    }
+    json_append_member(json.node, "slowest", slow);
+
+    multimap<int, string> sortedreasons;
+    for (const auto &entry : veto_messages)
+        sortedreasons.insert(make_pair(entry.second, entry.first));
+    JsonNode *reasons(json_mkarray());
+    for (auto i = sortedreasons.rbegin(); i != sortedreasons.rend(); ++i)
+    {
+        JsonNode *reason(json_mkobject());
+        json_append_member(reason, "message", json_mkstring(i->second.c_str()));
+        json_append_member(reason, "count", json_mknumber(i->first));
+        json_append_element(reasons, reason);
+    }
+    json_append_member(json.node, "veto_reasons", reasons);
+    json_append_member(json.node, "map_costs", _builder_costs_json(map_costs));
+    json_append_member(json.node, "layout_costs",
+                       _builder_costs_json(layout_costs));
+    json_append_member(json.node, "maps", json_mknumber(map_count()));
+    json_append_member(json.node, "selections", _selection_costs_json());
+
+    const char *out_file = "mapstat-bench.json";
+    FILE *outf = fopen_u(out_file, "w");
+    if (!outf)
+    {
+        fprintf(stderr, "Unable to open %s for writing.\n", out_file);
+        return;
+    }
+    fprintf(outf, "%s\n", json.to_string().c_str());
+    fclose(outf);
+
+    printf("%d level(s) built, %d failed, %d attempt(s), %d veto(es); "
+           "%.2fs building, %.2fs wall clock with %d job(s).\n",
+           (int) bench_records.size() - failed, failed, attempts, vetoes,
+           total / 1000000.0, wall_seconds, jobs);
+    printf("Wrote benchmark summary to %s.\n", out_file);
+}
+
+static void _mapstat_bench()
+{
+    int jobs = min(SysEnv.jobs, SysEnv.map_gen_iters);
+#ifndef UNIX
+    jobs = 1;
+#endif
+    jobs = max(jobs, 1);
+
+    printf("Timing %d dungeon(s) of %d level(s) with %d job(s).\n",
+           SysEnv.map_gen_iters, (int) generated_levels.size(), jobs);
+    fflush(stdout);
+
+    const auto start = chrono::steady_clock::now();
+    const int iters = SysEnv.map_gen_iters;
+    if (jobs == 1)
+        _bench_run_worker(0, 1);
+#ifdef UNIX
+    else
+    {
+        vector<pid_t> workers;
+        for (int w = 0; w < jobs; ++w)
+        {
+            fflush(stdout);
+            fflush(stderr);
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                _bench_run_worker(w, jobs);
+                _exit(_bench_write_worker_file(w) ? 0 : 1);
+            }
+            if (pid < 0)
+            {
+                fprintf(stderr, "Unable to start worker %d.\n", w);
+                break;
+            }
+            workers.push_back(pid);
+        }
+
+        for (int w = 0; w < (int) workers.size(); ++w)
+        {
+            int status = 0;
+            waitpid(workers[w], &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status)
+                || !_bench_read_worker_file(w))
+            {
+                fprintf(stderr, "Worker %d failed; its results are missing.\n",
+                        w);
+            }
+        }
+    }
+#endif
+    SysEnv.map_gen_iters = iters;
+
+    const double wall = chrono::duration<double>(
+                            chrono::steady_clock::now() - start).count();
+    _write_bench_stats(jobs, wall);
+}
+
 void mapstat_generate_stats()
 {
     // Warn assertions about possible oddities like the artefact list being
@@ -528,6 +1057,12 @@ void mapstat_generate_stats()
            (int) generated_levels.size(), branch_count);
     fflush(stdout);
 
+    if (crawl_state.map_stat_bench)
+    {
+        _mapstat_bench();
+        return;
+    }
+
     mapstat_build_levels();
 
     _write_map_stats();
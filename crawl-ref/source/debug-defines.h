@@ -24,6 +24,10 @@
     #define DEBUG_MONS_SCAN
 
     #define DEBUG_BONES
+
+    // Check every monster tracer answered from the tracer cache against a
+    // freshly fired one.
+    #define DEBUG_TRACER_CACHE
 #endif
 
 // on by default (and has been for ~10 years)
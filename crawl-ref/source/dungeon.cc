@@ -473,6 +473,9 @@ static bool _build_level_vetoable(bool enable_random_maps)
     catch (dgn_veto_exception& e)
     {
         dgn_record_veto(e);
+#ifdef DEBUG_STATISTICS
+        mapstat_report_map_build_end(false, env.level_layout_types);
+#endif
 
         // try not to lose any ghosts that have been placed
         save_ghosts(ghost_demon::find_ghosts(false), false);
@@ -485,6 +488,9 @@ static bool _build_level_vetoable(bool enable_random_maps)
         && !crawl_state.game_is_descent()
         && !_valid_dungeon_level())
     {
+#ifdef DEBUG_STATISTICS
+        mapstat_report_map_build_end(false, env.level_layout_types);
+#endif
         return false;
     }
 
@@ -512,6 +518,9 @@ static bool _build_level_vetoable(bool enable_random_maps)
 
     _dgn_postprocess_level();
 
+#ifdef DEBUG_STATISTICS
+    mapstat_report_map_build_end(true, env.level_layout_types);
+#endif
     env.level_layout_types.clear();
     env.level_uniq_maps.clear();
     env.level_uniq_map_tags.clear();
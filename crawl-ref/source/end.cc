@@ -16,6 +16,7 @@
 #include "database.h"
 #include "describe.h"
 #include "dungeon.h"
+#include "errors.h"
 #include "files.h"
 #include "god-abil.h"
 #include "god-passive.h"
@@ -143,8 +144,6 @@ bool CrawlIsCrashing = false;
 
 NORETURN void end(int exit_code, bool print_error, const char *format, ...)
 {
-    disable_other_crashes();
-
     // Let "error" go out of scope for valgrind's sake.
     {
         string error = print_error ? strerror(errno) : "";
@@ -165,6 +164,12 @@ NORETURN void end(int exit_code, bool print_error, const char *format, ...)
                 error += "\n";
         }
 
+        // Not the main thread; let that one end the game.
+        if (fatal_errors_throw)
+            throw fatal_thread_error(error);
+
+        disable_other_crashes();
+
         if (exit_code)
             fatal_error_notification(error);
 
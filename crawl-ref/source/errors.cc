@@ -14,6 +14,10 @@
 #include "stringutil.h"
 #include "syscalls.h"
 
+// Only set on threads other than the main one, which hand the error back to
+// it rather than take the game down themselves.
+thread_local bool fatal_errors_throw = false;
+
 NORETURN void fail(const char *msg, ...)
 {
     va_list args;
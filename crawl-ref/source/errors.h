@@ -26,4 +26,14 @@ struct corrupted_save : public ext_fail_exception
     save_version version; // defaults to -1,-1
 };
 
+// What ASSERT, die() and end() throw instead of ending the game, on a thread
+// that has set fatal_errors_throw; see package::_commit_thread().
+struct fatal_thread_error : public runtime_error
+{
+    fatal_thread_error(const string &msg) : runtime_error(msg) {}
+    fatal_thread_error(const char *msg) : runtime_error(msg) {}
+};
+
+extern thread_local bool fatal_errors_throw;
+
 extern bool CrawlIsCrashing;
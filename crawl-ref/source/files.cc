@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -86,6 +87,7 @@
 #include "tag-version.h"
 #include "teleport.h"
 #include "terrain.h"
+#include "threads.h"
 #ifdef USE_TILE
  // TODO -- dolls
  #include "rltiles/tiledef-player.h"
@@ -1043,12 +1045,37 @@ void write_ghost_version(writer &outf)
 
 static void _write_tagged_chunk(const string &chunkname, tag_type tag)
 {
-    writer outf(you.save, chunkname);
+    writer outf(you.save, chunkname, Options.background_save);
 
     write_save_version(outf, save_version::current());
     tag_write(tag, outf);
 }
 
+/**
+ * Save a level, and keep it in memory too, so that going back to it soon
+ * (say, going up and down the same stairs) doesn't need to read and
+ * decompress its chunk. The chunk is still written to the save as usual.
+ */
+static void _write_kept_level_chunk(const string &chunkname)
+{
+    auto data = make_shared<vector<unsigned char>>();
+    {
+        writer outf(data.get());
+        write_save_version(outf, save_version::current());
+        tag_write(TAG_LEVEL, outf);
+    }
+    // The background commit and the kept contents share the one buffer.
+    if (Options.background_save)
+        you.save->write_later(chunkname, data);
+    else
+    {
+        writer outf(you.save, chunkname);
+        outf.write(data->data(), data->size());
+    }
+    you.save->keep_in_memory(chunkname, data,
+                             (size_t)Options.level_cache_size * 1024);
+}
+
 static int _get_dest_stair_type(dungeon_feature_type stair_taken,
                                 bool &find_first)
 {
@@ -1678,6 +1705,108 @@ void reset_portal_entrances()
             brentry[b] = level_id();
 }
 
+/**
+ * Commits the levels built by pregen_dungeon() to the save.
+ *
+ * The builder works on global state and later levels depend on what earlier
+ * ones placed (uniques, unique vaults, ...), so levels are still built one at
+ * a time on the main thread. Once a level is serialised, though, compressing
+ * it is independent of everything else: that happens on worker threads while
+ * the next levels are being built. Chunks are written to the package strictly
+ * in the order the levels were generated, so the save is byte-for-byte the
+ * same as one from a sequential pregen.
+ */
+class level_commit_queue
+{
+public:
+    level_commit_queue(package *_save, int threads)
+        : save(_save), max_jobs(max(threads, 1))
+    {
+    }
+
+    ~level_commit_queue()
+    {
+        // Only reached with jobs left if pregen was interrupted; don't
+        // leave threads running, but don't write anything either.
+        for (auto &j : jobs)
+            if (j->threaded)
+                thread_join(j->thread);
+    }
+
+    void push(const string &name)
+    {
+        auto j = make_unique<job>();
+        j->name = name;
+        writer outf(&j->data);
+        write_save_version(outf, save_version::current());
+        tag_write(TAG_LEVEL, outf);
+
+        if (jobs.size() >= max_jobs)
+            commit_oldest();
+        j->threaded = !thread_create_joinable(&j->thread, _compress, j.get());
+        if (!j->threaded)
+            _compress(j.get());
+        jobs.push_back(move(j));
+    }
+
+    bool pending(const string &name) const
+    {
+        for (const auto &j : jobs)
+            if (j->name == name)
+                return true;
+        return false;
+    }
+
+    void commit_all()
+    {
+        while (!jobs.empty())
+            commit_oldest();
+    }
+
+private:
+    struct job
+    {
+        string name;
+        vector<unsigned char> data;
+        vector<unsigned char> zdata;
+        thread_t thread;
+        bool threaded = false;
+        bool ok = false;
+    };
+
+    static void *_compress(void *arg)
+    {
+        job *j = static_cast<job *>(arg);
+        j->ok = compress_chunk_data(j->data, j->zdata);
+        return nullptr;
+    }
+
+    void commit_oldest()
+    {
+        unique_ptr<job> j = move(jobs.front());
+        jobs.pop_front();
+        if (j->threaded)
+            thread_join(j->thread);
+        if (!j->ok)
+            fail("save file compression failed for %s", j->name.c_str());
+        save->write_compressed(j->name, j->zdata);
+    }
+
+    package *save;
+    size_t max_jobs;
+    deque<unique_ptr<job>> jobs;
+};
+
+// Set while pregen_dungeon() is building several levels.
+static level_commit_queue *pregen_commits = nullptr;
+
+// Whether a level chunk exists, or is waiting to be committed.
+static bool _level_chunk_saved(const string &name)
+{
+    return pregen_commits && pregen_commits->pending(name)
+           || you.save && you.save->has_chunk(name);
+}
+
 /**
  * Generate portals relative to the current level. This function does not clean
  * up builder state.
@@ -1701,7 +1830,7 @@ static int _generate_portal_levels()
         {
             // Should this crash? Reaching this case means that multiple
             // entrances to a non-reusable portal generated.
-            if (you.save->has_chunk(lid.describe()))
+            if (_level_chunk_saved(lid.describe()))
                 mprf(MSGCH_ERROR, "Portal %s already exists!", lid.describe().c_str());
             else
                 return -1;
@@ -1729,7 +1858,7 @@ static int _generate_portal_levels()
 bool generate_level(const level_id &l)
 {
     const string level_name = l.describe();
-    if (you.save->has_chunk(level_name))
+    if (_level_chunk_saved(level_name))
         return false;
 
     unwind_var<int> you_depth(you.depth, l.depth);
@@ -1803,6 +1932,8 @@ bool generate_level(const level_id &l)
     {
         // if portals were generated, we're currently elsewhere. Switch back to
         // the level generated before the portals.
+        if (pregen_commits)
+            pregen_commits->commit_all();
         ASSERT(you.save->has_chunk(save_name));
         dprf("Reloading new level '%s'.", save_name.c_str());
         _restore_tagged_chunk(you.save, save_name, TAG_LEVEL,
@@ -1954,6 +2085,14 @@ bool pregen_dungeon(const level_id &stopping_point)
         // be sure that AK start doesn't interfere with the builder
         unwind_var<game_chapter> chapter(you.chapter, CHAPTER_ORB_HUNTING);
 
+        unique_ptr<level_commit_queue> commits;
+        if (Options.pregen_threads > 0)
+        {
+            commits = make_unique<level_commit_queue>(you.save,
+                                                      Options.pregen_threads);
+        }
+        unwind_var<level_commit_queue *> queue(pregen_commits, commits.get());
+
         ui::progress_popup progress("Generating dungeon...\n\n", 35);
         progress.advance_progress();
 
@@ -1982,9 +2121,17 @@ bool pregen_dungeon(const level_id &stopping_point)
 
             // (save chunk existence is checked above, so isn't relevant here)
             if (!generate_level(new_level))
-                return false; // level failed to generate -- bail immediately
+            {
+                // level failed to generate -- bail immediately, keeping the
+                // levels that did generate, as a sequential pregen would.
+                if (commits)
+                    commits->commit_all();
+                return false;
+            }
         }
 
+        if (commits)
+            commits->commit_all();
         return true;
     }
 }
@@ -2527,7 +2674,12 @@ void save_level(const level_id& lid)
     // Nail all items to the ground.
     fix_item_coordinates();
 
-    _write_tagged_chunk(lid.describe(), TAG_LEVEL);
+    if (pregen_commits)
+        pregen_commits->push(lid.describe());
+    else if (Options.level_cache_size > 0)
+        _write_kept_level_chunk(lid.describe());
+    else
+        _write_tagged_chunk(lid.describe(), TAG_LEVEL);
 }
 
 #if TAG_MAJOR_VERSION == 34
@@ -2539,7 +2691,8 @@ void save_level(const level_id& lid)
 #define SAVEFILE(short, long, savefn)           \
     do                                          \
     {                                           \
-        writer w(you.save, CHUNK(short, long)); \
+        writer w(you.save, CHUNK(short, long),  \
+                 Options.background_save);      \
         savefn(w);                              \
     } while (false)
 
@@ -2646,7 +2799,10 @@ void save_game(bool leave_game, const char *farewellmsg)
 #endif
         if (!crawl_state.disables[DIS_SAVE_CHECKPOINTS])
         {
-            you.save->commit();
+            if (Options.background_save)
+                you.save->commit_async();
+            else
+                you.save->commit();
             save_game_prefs();
         }
         return;
@@ -3337,6 +3493,150 @@ bool restore_game(const string& filename)
     }
 }
 
+static double _usec_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, micro>(chrono::steady_clock::now()
+                                           - start).count();
+}
+
+/**
+ * Print where the space and the saving time go in the save for `name`, then
+ * exit. For each chunk, report its compressed and uncompressed size and its
+ * fragments, as `--edit-save <name> info` does. Then load the player and each
+ * level in turn and marshall them again into memory, as save_game() and
+ * save_level() would, timing each section of the tags. The save is opened
+ * read-only and left untouched.
+ */
+NORETURN void print_save_stats(const string &name)
+{
+    try
+    {
+        string filename = name;
+        // Check for the exact filename first, then go by char name.
+        if (!file_exists(filename))
+            filename = get_savedir_filename(filename);
+        you.save = new package(filename.c_str(), false);
+
+        vector<string> chunks = you.save->list_chunks();
+        sort(chunks.begin(), chunks.end(), numcmpstr);
+        plen_t frag = you.save->get_chunk_fragmentation("");
+        plen_t total_cclen = 0, total_clen = 0;
+        printf("Chunks: (size compressed/uncompressed, fragments, "
+               "decompression time, name)\n");
+        for (const string &chunk : chunks)
+        {
+            const plen_t cfrag = you.save->get_chunk_fragmentation(chunk);
+            const plen_t cclen = you.save->get_chunk_compressed_length(chunk);
+            frag += cfrag;
+
+            const auto start = chrono::steady_clock::now();
+            char buf[16384];
+            chunk_reader in(you.save, chunk);
+            plen_t clen = 0;
+            while (plen_t s = in.read(buf, sizeof(buf)))
+                clen += s;
+            const double usec = _usec_since(start);
+
+            total_cclen += cclen;
+            total_clen += clen;
+            printf("%8u/%8u %3u %9.3fms %s\n", cclen, clen, cfrag,
+                   usec / 1000, chunk.c_str());
+        }
+        printf("%8u/%8u total\n", total_cclen, total_clen);
+
+        const plen_t nchunks = chunks.size();
+        const plen_t flen = you.save->get_size();
+        const plen_t slack = you.save->get_slack();
+        // the directory is not a chunk visible from the outside
+        printf("Fragmentation:    %u/%u (%4.2f)\n", frag, nchunks + 1,
+               ((float)frag) / (nchunks + 1));
+        printf("Unused space:     %u/%u (%u%%)\n", slack, flen,
+               100 - (100 * (flen - slack) / flen));
+
+        const player_save_info save_info = _read_character_info(you.save);
+        if (!save_info.save_loadable)
+        {
+            fail("%s is from an incompatible version of Crawl (%s).",
+                 save_info.name.c_str(),
+                 save_info.prev_save_version.c_str());
+        }
+        you.init_from_save_info(save_info);
+
+        auto start = chrono::steady_clock::now();
+        _restore_tagged_chunk(you.save, "you", TAG_YOU,
+                              "Save data is invalid.");
+        double read_usec = _usec_since(start);
+
+        tag_profile profile;
+        tag_set_profile(&profile);
+        vector<unsigned char> buf;
+        {
+            writer outf(&buf);
+            tag_write(TAG_CHR, outf);
+            tag_write(TAG_YOU, outf);
+        }
+
+        int levels = 0;
+        for (const string &chunk : chunks)
+        {
+            level_id lid;
+            try
+            {
+                lid = level_id::parse_level_id(chunk);
+            }
+            catch (const bad_level_id &err)
+            {
+                continue;
+            }
+
+            you.where_are_you = lid.branch;
+            you.depth = lid.depth;
+            _generic_level_reset();
+
+            start = chrono::steady_clock::now();
+            _restore_tagged_chunk(you.save, chunk, TAG_LEVEL,
+                                  "Level file is invalid.");
+            read_usec += _usec_since(start);
+
+            buf.clear();
+            writer outf(&buf);
+            tag_write(TAG_LEVEL, outf);
+            levels++;
+        }
+        tag_set_profile(nullptr);
+
+        vector<pair<string, tag_section_stats>> sections(profile.begin(),
+                                                         profile.end());
+        sort(sections.begin(), sections.end(),
+             [](const pair<string, tag_section_stats> &a,
+                const pair<string, tag_section_stats> &b)
+             {
+                 return a.second.usec > b.second.usec;
+             });
+
+        printf("\nMarshalling the player and %d levels: "
+               "(calls, bytes, time, section)\n", levels);
+        for (const auto &section : sections)
+        {
+            const tag_section_stats &stats = section.second;
+            printf("%8d %10" PRIu64 " %9.3fms %s\n", stats.calls,
+                   stats.bytes, stats.usec / 1000, section.first.c_str());
+        }
+        printf("Props tables and level grids are also counted in the section "
+               "that wrote them.\n");
+        printf("Unmarshalling:    %.3fms\n", read_usec / 1000);
+
+        delete you.save;
+        you.save = 0;
+        end(0);
+    }
+    catch (ext_fail_exception &fe)
+    {
+        fprintf(stderr, "Error: %s\n", fe.what());
+        end(1);
+    }
+}
+
 static void _load_level(const level_id &level)
 {
     // Load the given level.
@@ -3352,7 +3652,7 @@ static void _load_level(const level_id &level)
 // is generated.
 bool is_existing_level(const level_id &level)
 {
-    return you.save && you.save->has_chunk(level.describe());
+    return _level_chunk_saved(level.describe());
 }
 
 void delete_level(const level_id &level)
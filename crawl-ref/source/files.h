@@ -72,6 +72,7 @@ bool check_mkdir(const string &what, string *dir, bool silent = false);
 vector<player_save_info> find_all_saved_characters();
 
 NORETURN void print_save_json(const char *name);
+NORETURN void print_save_stats(const string &name);
 
 string get_save_filename(const string &name);
 string get_savedir_filename(const string &name);
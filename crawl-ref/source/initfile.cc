@@ -572,6 +572,7 @@ const vector<GameOption*> game_options::build_options_list()
             [this]() { update_travel_terrain(); }),
         new BoolGameOption(SIMPLE_NAME(travel_one_unsafe_move), false),
         new BoolGameOption(SIMPLE_NAME(dump_on_save), true),
+        new BoolGameOption(SIMPLE_NAME(background_save), false),
         new BoolGameOption(SIMPLE_NAME(rest_wait_both), false),
         new BoolGameOption(SIMPLE_NAME(rest_wait_ancestor), false),
         new BoolGameOption(SIMPLE_NAME(cloud_status), !is_tiles()),
@@ -661,6 +662,8 @@ const vector<GameOption*> game_options::build_options_list()
         new IntGameOption(SIMPLE_NAME(rest_delay), USING_DGL ? -1 : 0,
                           -1, 2000),
         new IntGameOption(SIMPLE_NAME(explore_delay), -1, -1, 2000),
+        new IntGameOption(SIMPLE_NAME(pregen_threads), 0, 0, 64),
+        new IntGameOption(SIMPLE_NAME(level_cache_size), 0, 0, 1048576),
         new IntGameOption(SIMPLE_NAME(explore_item_greed), 10, -1000, 1000),
         new IntGameOption(SIMPLE_NAME(explore_wall_bias), 0, -1000, 1000),
         new IntGameOption(SIMPLE_NAME(scroll_margin_x), 2, 0),
@@ -4584,6 +4587,8 @@ enum commandline_option_type
     CLO_OBJSTAT,
     CLO_ITERATIONS,
     CLO_FORCE_MAP,
+    CLO_MAPSTAT_BENCH,
+    CLO_JOBS,
     CLO_ARENA,
     CLO_DUMP_MAPS,
     CLO_TEST,
@@ -4594,6 +4599,7 @@ enum commandline_option_type
     CLO_SEED,
     CLO_PREGEN,
     CLO_SAVE_VERSION,
+    CLO_SAVE_STATS,
     CLO_SPRINT,
     CLO_EXTRA_OPT_FIRST,
     CLO_EXTRA_OPT_LAST,
@@ -4643,6 +4649,8 @@ static set<commandline_option_type> clo_headless_ok = {
     CLO_MAPSTAT,
     CLO_MAPSTAT_DUMP_DISCONNECT,
     CLO_OBJSTAT,
+    CLO_MAPSTAT_BENCH,
+    CLO_SAVE_STATS,
 #ifndef USE_TILE_LOCAL
 // TODO: still too crashy in local tiles to enable
     CLO_RC,
@@ -4663,8 +4671,10 @@ static const char *cmd_ops[] =
 {
     "scores", "name", "species", "background", "dir", "rc", "rcdir", "tscores",
     "vscores", "scorefile", "morgue", "macro", "mapstat", "dump-disconnect",
-    "objstat", "iters", "force-map", "arena", "dump-maps", "test", "script",
-    "builddb", "help", "version", "seed", "pregen", "save-version", "sprint",
+    "objstat", "iters", "force-map", "mapstat-bench", "jobs", "arena",
+    "dump-maps", "test", "script",
+    "builddb", "help", "version", "seed", "pregen", "save-version",
+    "save-stats", "sprint",
     "extra-opt-first", "extra-opt-last", "sprint-map", "edit-save",
     "print-charset", "tutorial", "wizard", "explore", "no-save",
     "no-player-bones", "gdb", "no-gdb", "nogdb", "throttle", "no-throttle",
@@ -5495,6 +5505,7 @@ bool parse_args(int argc, char **argv, bool rc_only)
 
     SysEnv.rcdirs.clear();
     SysEnv.map_gen_iters = 0;
+    SysEnv.jobs = 1;
 
     if (argc < 2)           // no args!
         return true;
@@ -5623,12 +5634,15 @@ bool parse_args(int argc, char **argv, bool rc_only)
             break;
 
         case CLO_MAPSTAT:
+        case CLO_MAPSTAT_BENCH:
         case CLO_OBJSTAT:
 #ifdef DEBUG_STATISTICS
-            if (o == CLO_MAPSTAT)
-                crawl_state.map_stat_gen = true;
-            else
+            if (o == CLO_OBJSTAT)
                 crawl_state.obj_stat_gen = true;
+            else
+                crawl_state.map_stat_gen = true;
+            if (o == CLO_MAPSTAT_BENCH)
+                crawl_state.map_stat_bench = true;
             enter_headless_mode();
 
             if (!SysEnv.map_gen_iters)
@@ -5689,6 +5703,20 @@ bool parse_args(int argc, char **argv, bool rc_only)
 #endif
             break;
 
+        case CLO_JOBS:
+            if (!next_is_param || !isadigit(*next_arg))
+                end(1, false, "Integer argument required for -%s\n", arg);
+            else
+            {
+                SysEnv.jobs = atoi(next_arg);
+                if (SysEnv.jobs < 1)
+                    SysEnv.jobs = 1;
+                else if (SysEnv.jobs > 256)
+                    SysEnv.jobs = 256;
+                nextUsed = true;
+            }
+            break;
+
         case CLO_ARENA:
             if (!rc_only)
             {
@@ -5883,6 +5911,15 @@ bool parse_args(int argc, char **argv, bool rc_only)
             _print_save_version(next_arg);
             end(0);
 
+        case CLO_SAVE_STATS:
+            if (!next_is_param)
+                return false;
+
+            crawl_state.save_stats = next_arg;
+            enter_headless_mode();
+            nextUsed = true;
+            break;
+
         case CLO_SAVE_JSON:
             // Always parse.
             if (!next_is_param)
@@ -61,6 +61,7 @@ public:
     vector<string> cmd_args;
 
     int map_gen_iters;
+    int jobs;                      // Worker processes for batch modes.
     unique_ptr<depth_ranges> map_gen_range;
 
     vector<string> extra_opts_first;
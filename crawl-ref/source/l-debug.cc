@@ -5,7 +5,10 @@
 
 #include "l-libs.h"
 
+#include <chrono>
+
 #include "act-iter.h"
+#include "beam.h"
 #include "branch.h"
 #include "chardump.h"
 #include "cluautil.h"
@@ -20,13 +23,16 @@
 #include "mon-act.h"
 #include "mon-cast.h"
 #include "mon-death.h"
+#include "mon-pathfind.h"
 #include "mon-poly.h"
 #include "ng-setup.h"
 #include "religion.h"
 #include "stairs.h"
 #include "state.h"
 #include "stringutil.h"
+#include "tiles-build-specific.h"
 #include "tileview.h"
+#include "travel.h"
 #include "unique-creature-list-type.h"
 #include "unwind.h"
 #include "view.h"
@@ -474,6 +480,101 @@ LUAFN(debug_check_moncasts)
     return 1;
 }
 
+// Find a path for the monster at (x1, y1) to (x2, y2), using the cluster
+// graph unless the fifth argument is false. Returns the number of steps
+// (nil if there is no path), the nodes expanded and the time taken in
+// microseconds.
+LUAFN(debug_pathfind)
+{
+    COORDS(s, 1, 2);
+    COORDS(t, 3, 4);
+    const bool clusters = lua_isnoneornil(ls, 5) || lua_toboolean(ls, 5);
+
+    monster *mon = monster_at(s);
+    if (!mon)
+        return luaL_argerror(ls, 1, "no monster there");
+
+    monster_pathfind mp;
+    mp.set_cluster_search(clusters);
+    const auto begin = chrono::steady_clock::now();
+    const bool found = mp.init_pathfind(mon, t);
+    const auto usec = chrono::duration_cast<chrono::microseconds>(
+                          chrono::steady_clock::now() - begin).count();
+
+    if (found)
+        lua_pushnumber(ls, mp.backtrack().size() - 1);
+    else
+        lua_pushnil(ls);
+    lua_pushnumber(ls, mp.nodes_expanded());
+    lua_pushnumber(ls, usec);
+    return 3;
+}
+
+LUAWRAP(debug_magic_mapping,
+        magic_mapping(GDM, 100, true, true, false, true, false))
+
+// The square travel would move the player to next on the way to (x, y),
+// or nil if there is no way there.
+LUAFN(debug_travel_move)
+{
+    COORDS(dest, 1, 2);
+    // Tests run without a save, but travel wants a game in progress.
+    unwind_bool game(crawl_state.need_save, true);
+    travel_pathfind tp;
+    tp.set_src_dst(you.pos(), dest);
+    const coord_def move = tp.pathfind(RMODE_TRAVEL);
+    if (move.origin())
+        return 0;
+    lua_pushnumber(ls, move.x);
+    lua_pushnumber(ls, move.y);
+    return 2;
+}
+
+// Counts of monster tracers: the monster turns started, the tracers fired,
+// how many of those were answered from the tracer cache, how many cached
+// answers a fresh tracer disagreed with (see debug.check_tracer_cache), and
+// the most fired in one monster turn.
+LUAFN(debug_tracer_stats)
+{
+    const tracer_cache_stats &st = tracer_stats();
+    lua_newtable(ls);
+    LUA_PUSHINT("monster_turns", st.monster_turns);
+    LUA_PUSHINT("calls", st.calls);
+    LUA_PUSHINT("cached", st.cached);
+    LUA_PUSHINT("stale", st.stale);
+    LUA_PUSHINT("max_turn_calls", st.max_turn_calls);
+    return 1;
+}
+
+// Check each tracer answered from the cache against a freshly fired one,
+// counting disagreements in debug.tracer_stats().stale.
+LUAFN(debug_check_tracer_cache)
+{
+    check_tracer_cache(lua_toboolean(ls, 1));
+    return 0;
+}
+
+#ifdef USE_TILE_WEB
+// Build the webtiles map update for the current turn, even without anyone
+// watching, with the given map encoding (0 for plain JSON). If the second
+// argument is true, send the whole map. Returns the size of the message in
+// bytes and the time taken in microseconds.
+LUAFN(debug_webtiles_map_bench)
+{
+    const int encoding = luaL_safe_checkint(ls, 1);
+    const bool full = lua_toboolean(ls, 2);
+
+    const auto begin = chrono::steady_clock::now();
+    const int bytes = tiles.bench_map(encoding, full);
+    const auto usec = chrono::duration_cast<chrono::microseconds>(
+                          chrono::steady_clock::now() - begin).count();
+
+    lua_pushnumber(ls, bytes);
+    lua_pushnumber(ls, usec);
+    return 2;
+}
+#endif
+
 const struct luaL_reg debug_dlib[] =
 {
 { "goto_place", debug_goto_place },
@@ -506,5 +607,13 @@ const struct luaL_reg debug_dlib[] =
 { "reset_rng", debug_reset_rng },
 { "get_rng_state", debug_get_rng_state },
 { "check_moncasts", debug_check_moncasts },
+{ "pathfind", debug_pathfind },
+{ "magic_mapping", debug_magic_mapping },
+{ "travel_move", debug_travel_move },
+{ "tracer_stats", debug_tracer_stats },
+{ "check_tracer_cache", debug_check_tracer_cache },
+#ifdef USE_TILE_WEB
+{ "webtiles_map_bench", debug_webtiles_map_bench },
+#endif
 { nullptr, nullptr }
 };
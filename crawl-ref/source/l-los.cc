@@ -7,6 +7,7 @@
 
 #include "cluautil.h"
 #include "coord.h"
+#include "coordit.h"
 #include "losglobal.h"
 #include "los.h"
 #include "ray.h"
@@ -57,11 +58,69 @@ LUAFN(los_cell_see_cell)
     PLUARET(number, cell_see_cell(p, q, LOS_DEFAULT));
 }
 
+// Check that both losight() engines agree around the given cell, for
+// each of the usual opacity functions. Returns true, or false and the
+// first cell where they differ.
+LUAFN(los_check_engines)
+{
+    GETCOORD(c, 1, 2, map_bounds);
+    const opacity_func *opcs[] =
+    {
+        &opc_default, &opc_fullyopaque, &opc_no_trans, &opc_solid,
+        &opc_solid_see,
+    };
+    for (const opacity_func *opc : opcs)
+    {
+        los_grid raycast, bitmask;
+        losight(raycast, c, *opc, BDS_DEFAULT, los_engine::raycast);
+        losight(bitmask, c, *opc, BDS_DEFAULT, los_engine::bitmask);
+        for (rectangle_iterator ri(coord_def(0, 0), LOS_MAX_RANGE); ri; ++ri)
+        {
+            if (raycast(*ri) != bitmask(*ri))
+            {
+                lua_pushboolean(ls, false);
+                lua_pushnumber(ls, c.x + ri->x);
+                lua_pushnumber(ls, c.y + ri->y);
+                return 3;
+            }
+        }
+    }
+    lua_pushboolean(ls, true);
+    return 1;
+}
+
+static void _push_los_cache_stats(lua_State *ls, const los_cache_stats &st)
+{
+    lua_newtable(ls);
+    LUA_PUSHINT("hits", st.hits);
+    LUA_PUSHINT("misses", st.misses);
+    LUA_PUSHINT("invalidated", st.invalidated);
+    LUA_PUSHINT("flushes", st.flushes);
+}
+
+// Returns the cell_see_cell cache counters for the turn in progress,
+// or for the given period ("current", "last_turn" or "total").
+LUAFN(los_get_cache_stats)
+{
+    const string period = luaL_optstring(ls, 1, "current");
+    los_stats_period which = los_stats_period::current;
+    if (period == "last_turn")
+        which = los_stats_period::last_turn;
+    else if (period == "total")
+        which = los_stats_period::total;
+    else if (period != "current")
+        luaL_argerror(ls, 1, "expected current, last_turn or total");
+    _push_los_cache_stats(ls, get_los_cache_stats(which));
+    return 1;
+}
+
 const struct luaL_reg los_dlib[] =
 {
     { "findray", los_find_ray },
     { "make_ray", los_make_ray },
     { "cell_see_cell", los_cell_see_cell },
+    { "check_engines", los_check_engines },
+    { "cache_stats", los_get_cache_stats },
     { nullptr, nullptr }
 };
 
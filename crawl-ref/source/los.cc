@@ -46,6 +46,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 #include "areas.h"
 #include "coord.h"
@@ -53,6 +60,7 @@
 #include "env.h"
 #include "losglobal.h"
 #include "mon-act.h"
+#include "mon-pathfind.h"
 #include "mpr.h"
 
 // These determine what rays are cast in the precomputation,
@@ -85,12 +93,35 @@ static blockrays_t blockrays;
 struct cellray;
 static FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> min_cellrays;
 
+// For each cell p in the quadrant, the distinct end cells of those
+// minimal cellrays that p blocks, i.e. the cells whose visibility
+// may depend on the opacity of p. Used by losglobal to invalidate
+// only the affected part of the LOS cache.
+typedef FixedArray<vector<coord_def>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1>
+        blocked_ends_t;
+static blocked_ends_t blocked_ends;
+
 // Temporary arrays used in losight() to track which rays
 // are blocked or have seen a smoke cloud.
 // Allocated when doing the precomputations.
 static bit_vector *dead_rays     = nullptr;
 static bit_vector *smoke_rays    = nullptr;
 
+// The same information as blockrays, packed for the bitmask engine:
+// the rays blocked by quadrant cell p are the bits of the ray_words
+// words starting at ray_masks[_mask_offset(p)].
+typedef uint64_t ray_word;
+#define RAY_WORD_BITS 64
+static int ray_words = 0;
+static vector<ray_word> ray_masks;
+// Minimal cellrays are numbered in order of their end cell, so the
+// rays ending in quadrant cell p are exactly those in
+// [ray_range(p).first, ray_range(p).second).
+static FixedArray<pair<int, int>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> ray_range;
+// Scratch space for the bitmask engine, as dead_rays/smoke_rays.
+static vector<ray_word> dead_words;
+static vector<ray_word> smoke_words;
+
 class quadrant_iterator : public rectangle_iterator
 {
 public:
@@ -382,6 +413,42 @@ static void _register_ray(geom::ray r)
     fullrays.push_back(ray);
 }
 
+static int _mask_offset(const coord_def& p)
+{
+    return (p.x * (LOS_MAX_RANGE + 1) + p.y) * ray_words;
+}
+
+// Pack blockrays into ray_masks and find the ray range of each end cell.
+static void _create_ray_masks(int n_min_rays)
+{
+    ray_words = (n_min_rays + RAY_WORD_BITS - 1) / RAY_WORD_BITS;
+    ray_masks.assign((LOS_MAX_RANGE + 1) * (LOS_MAX_RANGE + 1) * ray_words, 0);
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        ray_word *mask = &ray_masks[_mask_offset(*qi)];
+        for (int i = 0; i < n_min_rays; ++i)
+            if (blockrays(*qi)->get(i))
+                mask[i / RAY_WORD_BITS] |= ray_word(1) << (i % RAY_WORD_BITS);
+        ray_range(*qi) = make_pair(0, 0);
+    }
+
+    for (int i = 0; i < n_min_rays; ++i)
+    {
+        pair<int, int> &range = ray_range(cellray_ends[i]);
+        if (range.first == range.second)
+            range = make_pair(i, i + 1);
+        else
+        {
+            // _find_minimal_cellrays() groups the rays by end cell.
+            ASSERT(range.second == i);
+            range.second++;
+        }
+    }
+
+    dead_words.assign(ray_words, 0);
+    smoke_words.assign(ray_words, 0);
+}
+
 static void _create_blockrays()
 {
     // First, we calculate blocking information for all cell rays.
@@ -428,9 +495,22 @@ static void _create_blockrays()
     for (quadrant_iterator qi; qi; ++qi)
         delete all_blockrays(*qi);
 
+    // Record which targets each cell can block, for cache invalidation.
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        vector<coord_def> &ends = blocked_ends(*qi);
+        for (int i = 0; i < n_min_rays; ++i)
+            if (blockrays(*qi)->get(i))
+                ends.push_back(cellray_ends[i]);
+        sort(ends.begin(), ends.end());
+        ends.erase(unique(ends.begin(), ends.end()), ends.end());
+    }
+
     dead_rays  = new bit_vector(n_min_rays);
     smoke_rays = new bit_vector(n_min_rays);
 
+    _create_ray_masks(n_min_rays);
+
     dprf("Cellrays: %d Fullrays: %u Minimal cellrays: %u",
           n_cellrays, (unsigned int)fullrays.size(), n_min_rays);
 }
@@ -506,6 +586,18 @@ static void raycast()
     _create_blockrays();
 }
 
+const vector<coord_def>& los_blocked_targets(const coord_def& p)
+{
+    ASSERT(p.x >= 0);
+    ASSERT(p.y >= 0);
+    ASSERT(p.rdist() <= LOS_MAX_RANGE);
+
+    // Ensure the precalculations have been done.
+    raycast();
+
+    return blocked_ends(p);
+}
+
 static int _imbalance(ray_def ray, const coord_def& target)
 {
     int imb = 0;
@@ -800,8 +892,191 @@ struct los_param_funcs : public los_param
     }
 };
 
+// The bitmask engine.
+//
+// This computes the same thing as _losight_quadrant, but first gathers
+// the opacity of the whole square into bit rows, and then only touches
+// the ray masks of cells that are actually (half-)opaque. Combining the
+// masks and reading off the visible cells works on whole words at a
+// time, several at once where SSE2 or AVX2 is available.
+
+// dst |= src, for n words.
+static inline void _or_rays(ray_word *dst, const ray_word *src, int n)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        const __m256i m = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(d, m));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        const __m128i m = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(d, m));
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] |= src[i];
+}
+
+// dead |= smoke & src; smoke |= src, for n words.
+static inline void _or_smoke_rays(ray_word *dead, ray_word *smoke,
+                                  const ray_word *src, int n)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(dead + i));
+        const __m256i s = _mm256_loadu_si256((const __m256i *)(smoke + i));
+        const __m256i m = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dead + i),
+                            _mm256_or_si256(d, _mm256_and_si256(s, m)));
+        _mm256_storeu_si256((__m256i *)(smoke + i), _mm256_or_si256(s, m));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128i d = _mm_loadu_si128((const __m128i *)(dead + i));
+        const __m128i s = _mm_loadu_si128((const __m128i *)(smoke + i));
+        const __m128i m = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dead + i),
+                         _mm_or_si128(d, _mm_and_si128(s, m)));
+        _mm_storeu_si128((__m128i *)(smoke + i), _mm_or_si128(s, m));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dead[i] |= smoke[i] & src[i];
+        smoke[i] |= src[i];
+    }
+}
+
+// Is any ray in [first, last) not marked in dead?
+static bool _any_ray_alive(const ray_word *dead, int first, int last)
+{
+    for (int i = first; i < last;)
+    {
+        const int w = i / RAY_WORD_BITS;
+        const int lo = i % RAY_WORD_BITS;
+        const int hi = min(last - w * RAY_WORD_BITS, RAY_WORD_BITS);
+        ray_word want = ~ray_word(0) << lo;
+        if (hi < RAY_WORD_BITS)
+            want &= (ray_word(1) << hi) - 1;
+        if (~dead[w] & want)
+            return true;
+        i = (w + 1) * RAY_WORD_BITS;
+    }
+    return false;
+}
+
+// Opacity and bounds of the square around the centre, one bit per cell.
+// Row y of the quadrant (sx, sy) holds cells (sx*x, sy*y) for x = 0..R.
+typedef FixedVector<uint16_t, LOS_MAX_RANGE + 1> los_bitrows;
+COMPILE_CHECK(LOS_MAX_RANGE < 16);
+
+static void _losight_quadrant_bitmask(los_grid& sh, const los_bitrows& opaque,
+                                      const los_bitrows& half,
+                                      const los_bitrows& inbounds,
+                                      int sx, int sy)
+{
+    ray_word *dead = dead_words.data();
+    ray_word *smoke = smoke_words.data();
+    memset(dead, 0, ray_words * sizeof(ray_word));
+    memset(smoke, 0, ray_words * sizeof(ray_word));
+
+    // Block the rays that pass through opaque cells, and those that
+    // pass through two or more half-opaque cells. Both are unions, so
+    // unlike _losight_quadrant the order of cells doesn't matter.
+    for (int y = 0; y <= LOS_MAX_RANGE; ++y)
+    {
+        for (int x = 0; opaque[y] >> x; ++x)
+            if (opaque[y] >> x & 1)
+            {
+                _or_rays(dead, &ray_masks[_mask_offset(coord_def(x, y))],
+                         ray_words);
+            }
+        for (int x = 0; half[y] >> x; ++x)
+            if (half[y] >> x & 1)
+            {
+                _or_smoke_rays(dead, smoke,
+                               &ray_masks[_mask_offset(coord_def(x, y))],
+                               ray_words);
+            }
+    }
+
+    // A cell is visible if any ray ending there is alive.
+    for (int y = 0; y <= LOS_MAX_RANGE; ++y)
+        for (int x = 0; inbounds[y] >> x; ++x)
+        {
+            if (!(inbounds[y] >> x & 1))
+                continue;
+            const pair<int, int> &range = ray_range(coord_def(x, y));
+            if (_any_ray_alive(dead, range.first, range.second))
+                sh(coord_def(sx * x, sy * y)) = true;
+        }
+}
+
+static void _losight_bitmask(los_grid& sh, const los_param& dat)
+{
+    const int quadrant_x[4] = {  1, -1, -1,  1 };
+    const int quadrant_y[4] = {  1,  1, -1, -1 };
+    los_bitrows opaque[4], half[4], inbounds[4];
+    for (int q = 0; q < 4; ++q)
+    {
+        opaque[q].init(0);
+        half[q].init(0);
+        inbounds[q].init(0);
+    }
+
+    // Look up each cell once, even those on the axes that belong
+    // to two quadrants.
+    for (rectangle_iterator ri(coord_def(0, 0), LOS_MAX_RANGE); ri; ++ri)
+    {
+        const coord_def p = *ri;
+        if (!dat.los_bounds(p))
+            continue;
+        const opacity_type opc = dat.opacity(p);
+        const int x = abs(p.x);
+        const int y = abs(p.y);
+        for (int q = 0; q < 4; ++q)
+        {
+            if (p.x * quadrant_x[q] < 0 || p.y * quadrant_y[q] < 0)
+                continue;
+            inbounds[q][y] |= 1 << x;
+            if (opc == OPC_OPAQUE)
+                opaque[q][y] |= 1 << x;
+            else if (opc == OPC_HALF)
+                half[q][y] |= 1 << x;
+        }
+    }
+
+    for (int q = 0; q < 4; ++q)
+    {
+        _losight_quadrant_bitmask(sh, opaque[q], half[q], inbounds[q],
+                                  quadrant_x[q], quadrant_y[q]);
+    }
+}
+
 void losight(los_grid& sh, const coord_def& center,
              const opacity_func& opc, const circle_def& bounds)
+{
+#ifdef USE_LOS_BITMASK
+    losight(sh, center, opc, bounds, los_engine::bitmask);
+#else
+    losight(sh, center, opc, bounds, los_engine::raycast);
+#endif
+}
+
+void losight(los_grid& sh, const coord_def& center,
+             const opacity_func& opc, const circle_def& bounds,
+             los_engine engine)
 {
     const los_param& dat = los_param_funcs(center, opc, bounds);
 
@@ -810,10 +1085,15 @@ void losight(los_grid& sh, const coord_def& center,
     // Do precomputations if necessary.
     raycast();
 
-    const int quadrant_x[4] = {  1, -1, -1,  1 };
-    const int quadrant_y[4] = {  1,  1, -1, -1 };
-    for (int q = 0; q < 4; ++q)
-        _losight_quadrant(sh, dat, quadrant_x[q], quadrant_y[q]);
+    if (engine == los_engine::bitmask)
+        _losight_bitmask(sh, dat);
+    else
+    {
+        const int quadrant_x[4] = {  1, -1, -1,  1 };
+        const int quadrant_y[4] = {  1,  1, -1, -1 };
+        for (int q = 0; q < 4; ++q)
+            _losight_quadrant(sh, dat, quadrant_x[q], quadrant_y[q]);
+    }
 
     // Center is always visible.
     const coord_def o = coord_def(0,0);
@@ -850,6 +1130,13 @@ static bool _mons_block_sight(const monster* mons)
 
 void los_actor_moved(const actor* act, const coord_def& oldpos)
 {
+    // Stationary monsters block monster paths.
+    if (act->is_monster() && act->is_stationary())
+    {
+        cluster_graph_changed(oldpos);
+        cluster_graph_changed(act->pos());
+    }
+
     if (act->is_monster() && _mons_block_sight(act->as_monster()))
     {
         invalidate_los_around(oldpos);
@@ -860,6 +1147,9 @@ void los_actor_moved(const actor* act, const coord_def& oldpos)
 
 void los_monster_died(const monster* mon)
 {
+    if (mon->is_stationary())
+        cluster_graph_changed(mon->pos());
+
     if (_mons_block_sight(mon))
     {
         invalidate_los_around(mon->pos());
@@ -871,12 +1161,14 @@ void los_monster_died(const monster* mon)
 void los_terrain_changed(const coord_def& p)
 {
     invalidate_los_around(p);
+    cluster_graph_changed(p);
     _handle_los_change();
 }
 
 void los_changed()
 {
     mons_reset_just_seen();
+    cluster_graph_reset();
     invalidate_los();
     _handle_los_change();
 }
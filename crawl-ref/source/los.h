@@ -32,14 +32,27 @@ dungeon_feature_type ray_blocker(const coord_def& source, const coord_def& targe
 void fallback_ray(const coord_def& source, const coord_def& target,
                   ray_def& ray);
 
+const vector<coord_def>& los_blocked_targets(const coord_def& p);
+
 bool cell_see_cell_nocache(const coord_def& p1, const coord_def& p2);
 
 typedef SquareArray<bool, LOS_MAX_RANGE> los_grid;
 
+// Ways to compute losight(); both give identical results. Which one
+// losight() uses by default is chosen at build time (USE_LOS_BITMASK).
+enum class los_engine
+{
+    raycast, // walk the cells of each quadrant, combining their ray sets
+    bitmask, // gather opacity into bit rows, combine packed ray masks
+};
+
 void clear_rays_on_exit();
 void losight(los_grid& sh, const coord_def& center,
              const opacity_func &opc = opc_default,
              const circle_def &bds = BDS_DEFAULT);
+void losight(los_grid& sh, const coord_def& center,
+             const opacity_func &opc, const circle_def &bds,
+             los_engine engine);
 
 void los_actor_moved(const actor* act, const coord_def& oldpos);
 void los_monster_died(const monster* mon);
@@ -5,7 +5,7 @@
 #include "coord.h"
 #include "coordit.h"
 #include "libutil.h"
-#include "los-def.h"
+#include "los.h"
 
 #define LOS_KNOWN 4
 
@@ -17,6 +17,14 @@ typedef halflos_t globallos_t[GXM][GYM];
 
 static globallos_t globallos;
 
+static los_cache_stats stats_turn;
+static los_cache_stats stats_last_turn;
+static los_cache_stats stats_total;
+
+// Opacity generation: bumped on every opacity change, so that caches built
+// on top of LOS can tell when to start over.
+static unsigned int opacity_generation = 1;
+
 static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
 {
     COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
@@ -33,9 +41,8 @@ static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
         return &globallos[p.x][p.y][ diff.x + o_half_x][ diff.y + o_half_y];
 }
 
-static void _save_los(los_def* los, los_type l)
+static void _save_los(const coord_def& o, const los_grid& view, los_type l)
 {
-    const coord_def o = los->get_center();
     int y1 = o.y - LOS_MAX_RANGE;
     int y2 = o.y + LOS_MAX_RANGE;
     int x1 = o.x - LOS_MAX_RANGE;
@@ -51,7 +58,7 @@ static void _save_los(los_def* los, los_type l)
             if (!flags)
                 continue;
             *flags |= l << LOS_KNOWN;
-            if (los->see_cell(ri))
+            if (view(ri - o))
                 *flags |= l;
             else
                 *flags &= ~l;
@@ -59,60 +66,85 @@ static void _save_los(los_def* los, los_type l)
 }
 
 // Opacity at p has changed.
+//
+// Only forget those pairs (o, q) such that p lies on a minimal cellray
+// from o to q; every other cached result is unaffected. Since we visit
+// every centre o in range of p, this covers rays in both directions
+// regardless of which end of the pair the result was computed from.
 void invalidate_los_around(const coord_def& p)
 {
-    int x1 = max(p.x - LOS_MAX_RANGE, 0);
-    int y1 = max(p.y - LOS_MAX_RANGE, 0);
-    int x2 = min(p.x, GXM - 1);
-    int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+    int dropped = 0;
+    opacity_generation++;
+    for (rectangle_iterator ri(p, LOS_MAX_RANGE); ri; ++ri)
+    {
+        const coord_def o = *ri;
+        const coord_def d = p - o;
+        // The centre's own opacity never matters.
+        if (d.origin() || !map_bounds(o))
+            continue;
+
+        const coord_def ad(abs(d.x), abs(d.y));
+        const vector<coord_def> &targets = los_blocked_targets(ad);
+        // Cells on an axis belong to both adjacent quadrants.
+        for (int sx = -1; sx <= 1; sx += 2)
+        {
+            if (d.x * sx < 0)
+                continue;
+            for (int sy = -1; sy <= 1; sy += 2)
+            {
+                if (d.y * sy < 0)
+                    continue;
+                for (const coord_def &t : targets)
+                {
+                    losfield_t* flags = _lookup_globallos(o,
+                                    coord_def(o.x + sx * t.x, o.y + sy * t.y));
+                    if (flags && *flags)
+                    {
+                        *flags = 0;
+                        dropped++;
+                    }
+                }
+            }
+        }
+    }
+    stats_turn.invalidated += dropped;
+    stats_total.invalidated += dropped;
 }
 
 void invalidate_los()
 {
     for (rectangle_iterator ri(0); ri; ++ri)
         memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    opacity_generation++;
+    stats_turn.flushes++;
+    stats_total.flushes++;
 }
 
-static void _update_globallos_at(const coord_def& p, los_type l)
+static const opacity_func& _los_type_opacity(los_type l)
 {
     switch (l)
     {
-    case LOS_DEFAULT:
-        {
-            los_def los(p, opc_default);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_NO_TRANS:
-        {
-            los_def los(p, opc_no_trans);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_SOLID:
-        {
-            los_def los(p, opc_solid);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
-    case LOS_SOLID_SEE:
-        {
-            los_def los(p, opc_solid_see);
-            los.update();
-            _save_los(&los, l);
-            break;
-        }
+    case LOS_DEFAULT:   return opc_default;
+    case LOS_NO_TRANS:  return opc_no_trans;
+    case LOS_SOLID:     return opc_solid;
+    case LOS_SOLID_SEE: return opc_solid_see;
     default:
         die("invalid opacity");
     }
 }
 
+unsigned int los_generation()
+{
+    return opacity_generation;
+}
+
+static void _update_globallos_at(const coord_def& p, los_type l)
+{
+    los_grid view;
+    losight(view, p, _los_type_opacity(l));
+    _save_los(p, view, l);
+}
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
 {
     if (l == LOS_NONE)
@@ -124,8 +156,41 @@ bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
         return false; // outside range
 
     if (!(*flags & (l << LOS_KNOWN)))
+    {
+        stats_turn.misses++;
+        stats_total.misses++;
         _update_globallos_at(p, l);
+    }
+    else
+    {
+        stats_turn.hits++;
+        stats_total.hits++;
+    }
 
     ASSERT(*flags & (l << LOS_KNOWN));
     return *flags & l;
 }
+
+void los_cache_new_turn()
+{
+    stats_last_turn = stats_turn;
+    stats_turn = los_cache_stats();
+}
+
+/**
+ * Get the LOS cache counters.
+ *
+ * @param which Whether to return the counts for the turn in progress, for
+ *              the last completed turn, or since the game was started.
+ */
+const los_cache_stats& get_los_cache_stats(los_stats_period which)
+{
+    switch (which)
+    {
+    case los_stats_period::current: return stats_turn;
+    case los_stats_period::last_turn: return stats_last_turn;
+    case los_stats_period::total:
+    default:
+        return stats_total;
+    }
+}
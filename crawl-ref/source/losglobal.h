@@ -6,3 +6,24 @@ void invalidate_los_around(const coord_def& p);
 void invalidate_los();
 
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l);
+
+unsigned int los_generation();
+
+// Counters for the cell_see_cell() cache.
+struct los_cache_stats
+{
+    int hits = 0;        // queries answered from the cache
+    int misses = 0;      // queries that had to recompute LOS
+    int invalidated = 0; // cached pairs dropped by local opacity changes
+    int flushes = 0;     // whole-cache invalidations
+};
+
+enum class los_stats_period
+{
+    current,
+    last_turn,
+    total,
+};
+
+void los_cache_new_turn();
+const los_cache_stats& get_los_cache_stats(los_stats_period which);
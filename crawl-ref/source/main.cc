@@ -86,6 +86,7 @@
 #include "level-state-type.h"
 #include "libutil.h"
 #include "lookup-help.h"
+#include "losglobal.h"
 #include "luaterp.h"
 #include "macro.h"
 #include "makeitem.h"
@@ -523,6 +524,7 @@ static void _show_commandline_options_help()
     puts("  -macro <dir>          directory to save/find macro.txt");
     puts("  -version              Crawl version (and compilation info)");
     puts("  -save-version <name>  Save file version for the given player");
+    puts("  -save-stats <name>    size and marshalling time of each part of a save");
     puts("  -sprint               select Sprint");
     puts("  -sprint-map <name>    preselect a Sprint map");
     puts("  -tutorial             select the Tutorial");
@@ -587,11 +589,14 @@ static void _show_commandline_options_help()
          "iterations");
     puts("  -force-map <map>    For -mapstat and -objstat, always choose the "
          "      given map on every level.");
+    puts("  -mapstat-bench [<levels>] time level builds over -iters dungeons");
+    puts("      and write a summary to mapstat-bench.json");
 #endif
     puts("");
     puts("Miscellaneous options:");
     puts("  -builddb         don't start the game; rebuild the .des cache and exit");
     puts("  -reset-cache     force a full rebuild of the .des cache");
+    puts("  -jobs <num>      worker processes for -builddb and -mapstat-bench");
     puts("  -dump-maps       write map Lua to stderr when parsing .des files");
 #ifndef TARGET_OS_WINDOWS
     puts("  -gdb/-no-gdb     produce gdb backtrace when a crash happens (default:on)");
@@ -2669,6 +2674,7 @@ void world_reacts()
         record_turn_timestamp();
         update_turn_count();
         msgwin_new_turn();
+        los_cache_new_turn();
         crawl_state.lua_calls_no_turn = 0;
         if ((crawl_state.game_is_sprint() && !(you.num_turns % 256)
                 || crawl_state.save_after_turn)
@@ -2385,13 +2385,10 @@ void map_def::write_full(writer& outf) const
 
 void map_def::read_full(reader& inf)
 {
-    // There's a potential race-condition here:
-    // - If someone modifies a .des file while there are games in progress,
-    // - a new Crawl process will overwrite the .dsc.
-    // - older Crawl processes trying to reading the new .dsc will be hosed.
-    // We could try to recover from the condition (by locking and
-    // reloading the index), but it's easier to save the game at this
-    // point and let the player reload.
+    // The vault cache is replaced rather than rewritten when a .des file
+    // changes, so games in progress keep reading the version they mapped.
+    // A map that fails these checks means the cache itself is damaged;
+    // it's easier to save the game at this point and let the player reload.
 
     const auto version = get_save_version(inf);
     const auto major = version.major, minor = version.minor;
@@ -2469,18 +2466,28 @@ void map_def::load()
     if (!index_only)
         return;
 
-    const string descache_base = get_descache_path(cache_name, "");
-    file_lock deslock(descache_base + ".lk", "rb", false);
-    const string loadfile = descache_base + ".dsc";
+    const unsigned char *data;
+    size_t length;
+    if (!find_vault_cache_section(cache_name, data, length))
+    {
+        throw map_load_exception(
+                make_stringf("Map is missing from the vault cache: %s",
+                             name.c_str()));
+    }
 
-    reader inf(loadfile, TAG_MINOR_VERSION);
-    if (!inf.valid())
+    reader inf(data, length, TAG_MINOR_VERSION);
+    inf.set_safe_read(true);
+    try
+    {
+        inf.advance(cache_offset);
+        read_full(inf);
+    }
+    catch (short_read_exception &E)
     {
         throw map_load_exception(
-                make_stringf("Map inf is invalid: %s", name.c_str()));
+                make_stringf("Vault cache entry is truncated: %s",
+                             name.c_str()));
     }
-    inf.advance(cache_offset);
-    read_full(inf);
 
     index_only = false;
 }
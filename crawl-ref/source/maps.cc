@@ -8,13 +8,19 @@
 #include "maps.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <unordered_map>
 #include <sys/param.h>
 #include <sys/types.h>
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#ifdef UNIX
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
 
 #include "branch.h"
 #include "coord.h"
@@ -24,6 +30,7 @@
 #include "end.h"
 #include "endianness.h"
 #include "files.h"
+#include "initfile.h"
 #include "mapmark.h"
 #include "message.h"
 #include "state.h"
@@ -31,6 +38,7 @@
 #include "syscalls.h"
 #include "tag-version.h"
 #include "terrain.h"
+#include "unwind.h"
 
 #ifndef BYTE_ORDER
 # error BYTE_ORDER is not defined
@@ -761,16 +769,194 @@ vector<string> find_map_matches(const string &name)
     return matches;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// Map selection indexes
+//
+// Rather than testing every map against each selector, selections look up
+// the maps that could match in indexes by tag, DEPTH and PLACE, and run the
+// full checks on those candidates only. The indexes are rebuilt from vdefs
+// the first time they are needed after the map list changes. Candidate lists
+// are kept in vdefs order, so random choices made from them are the same as
+// with a scan of all maps.
+
+typedef vector<unsigned> vault_indices;
+
+// The level ranges of one DEPTH or PLACE field of every map, by branch.
+class level_range_index
+{
+public:
+    void clear();
+    void add(unsigned map, const depth_ranges &ranges);
+    void finish();
+    void candidates(const level_id &place, vault_indices &out) const;
+
+private:
+    struct branch_range
+    {
+        int shallowest, deepest;
+        unsigned map;
+
+        bool operator < (const branch_range &other) const
+        {
+            return shallowest < other.shallowest
+                   || shallowest == other.shallowest && map < other.map;
+        }
+    };
+
+    // Sorted by shallowest level, so a lookup can stop at the first range
+    // starting below the level it wants.
+    vector<branch_range> branch_ranges[NUM_BRANCHES];
+    // Ranges starting at the end of a branch ("$"), whose depth depends on
+    // the branch layout of the game.
+    vault_indices branch_end[NUM_BRANCHES];
+    // Ranges in branch "any", which count absolute dungeon depth.
+    vault_indices any_branch;
+};
+
+void level_range_index::clear()
+{
+    for (auto &ranges : branch_ranges)
+        ranges.clear();
+    for (auto &maps : branch_end)
+        maps.clear();
+    any_branch.clear();
+}
+
+void level_range_index::add(unsigned map, const depth_ranges &ranges)
+{
+    for (const level_range &lr : ranges.ranges())
+    {
+        // A denied range never makes a map usable.
+        if (lr.deny)
+            continue;
+        if (lr.branch == NUM_BRANCHES)
+            any_branch.push_back(map);
+        else if (lr.shallowest == BRANCH_END)
+            branch_end[lr.branch].push_back(map);
+        else
+            branch_ranges[lr.branch].push_back({lr.shallowest, lr.deepest, map});
+    }
+}
+
+void level_range_index::finish()
+{
+    for (auto &ranges : branch_ranges)
+        sort(ranges.begin(), ranges.end());
+}
+
+/**
+ * Find the maps that might be usable in a level.
+ *
+ * @param place The level.
+ * @param[out] out The indices into vdefs of every map with a range that
+ *                 might match place, in order. Maps whose other ranges deny
+ *                 the level are included; callers must still check.
+ */
+void level_range_index::candidates(const level_id &place,
+                                   vault_indices &out) const
+{
+    out = any_branch;
+    if (place.branch < NUM_BRANCHES)
+    {
+        for (const branch_range &range : branch_ranges[place.branch])
+        {
+            if (range.shallowest > place.depth)
+                break;
+            if (place.depth <= range.deepest)
+                out.push_back(range.map);
+        }
+        if (place.depth == brdepth[place.branch])
+        {
+            out.insert(out.end(), branch_end[place.branch].begin(),
+                       branch_end[place.branch].end());
+        }
+    }
+    sort(out.begin(), out.end());
+    out.erase(unique(out.begin(), out.end()), out.end());
+}
+
+static struct
+{
+    bool valid = false;
+    unordered_map<string, vault_indices> tags;
+    level_range_index depths;
+    level_range_index places;
+} map_index;
+
+static void _invalidate_map_index()
+{
+    map_index.valid = false;
+}
+
+static void _build_map_index()
+{
+    if (map_index.valid)
+        return;
+
+    map_index.tags.clear();
+    map_index.depths.clear();
+    map_index.places.clear();
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+    {
+        for (const string &tag : vdefs[i].get_tags_unsorted())
+            map_index.tags[tag].push_back(i);
+        map_index.depths.add(i, vdefs[i].depths);
+        map_index.places.add(i, vdefs[i].place);
+    }
+    map_index.depths.finish();
+    map_index.places.finish();
+    map_index.valid = true;
+}
+
+static void _all_maps(vault_indices &out)
+{
+    out.resize(vdefs.size());
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+        out[i] = i;
+}
+
+// The maps that have all of tags: the shortest of their lists in the index.
+static void _maps_with_tags(const unordered_set<string> &tags,
+                            vault_indices &out)
+{
+    _build_map_index();
+    if (tags.empty())
+    {
+        _all_maps(out);
+        return;
+    }
+
+    const vault_indices *shortest = nullptr;
+    for (const string &tag : tags)
+    {
+        const auto found = map_index.tags.find(tag);
+        if (found == map_index.tags.end())
+        {
+            out.clear();
+            return;
+        }
+        if (!shortest || found->second.size() < shortest->size())
+            shortest = &found->second;
+    }
+    out = *shortest;
+}
+
 mapref_vector find_maps_for_tag(const string &tag,
                                 bool check_depth,
                                 bool check_used)
 {
+#ifdef DEBUG_STATISTICS
+    const auto start = chrono::steady_clock::now();
+#endif
     mapref_vector maps;
     level_id place = level_id::current();
     unordered_set<string> tag_set = parse_tags(tag);
 
-    for (const map_def &mapdef : vdefs)
+    vault_indices candidates;
+    _maps_with_tags(tag_set, candidates);
+    for (const unsigned i : candidates)
     {
+        const map_def &mapdef = vdefs[i];
         if (mapdef.has_all_tags(tag_set.begin(), tag_set.end())
             && !mapdef.has_tag("dummy")
             && (!check_depth || _debug_ignore_depth
@@ -781,6 +967,11 @@ mapref_vector find_maps_for_tag(const string &tag,
             maps.push_back(&mapdef);
         }
     }
+#ifdef DEBUG_STATISTICS
+    mapstat_report_map_selection("find_maps_for_tag", candidates.size(),
+        maps.size(), chrono::duration_cast<chrono::microseconds>(
+                        chrono::steady_clock::now() - start).count());
+#endif
     return maps;
 }
 
@@ -798,6 +989,8 @@ private:
 public:
     bool accept(const map_def &md) const;
     void announce(const map_def *map) const;
+    void candidates(vault_indices &out) const;
+    const char *describe() const;
 
     bool valid() const
     {
@@ -952,6 +1145,44 @@ bool map_selector::accept(const map_def &mapdef) const
     }
 }
 
+/**
+ * Find the maps this selector might accept.
+ *
+ * @param[out] out The indices into vdefs of the candidate maps, in order.
+ */
+void map_selector::candidates(vault_indices &out) const
+{
+    switch (sel)
+    {
+    case PLACE:
+        _build_map_index();
+        map_index.places.candidates(place, out);
+        break;
+
+    case DEPTH:
+    case DEPTH_AND_CHANCE:
+        _build_map_index();
+        map_index.depths.candidates(place, out);
+        break;
+
+    case TAG:
+        _maps_with_tags(parse_tags(tag), out);
+        break;
+
+    default:
+        out.clear();
+        break;
+    }
+}
+
+const char *map_selector::describe() const
+{
+    return sel == PLACE ? "place" :
+           sel == DEPTH ? "depth" :
+           sel == DEPTH_AND_CHANCE ? "depth and chance" :
+           "tag";
+}
+
 void map_selector::announce(const map_def *vault) const
 {
 #ifdef DEBUG_DIAGNOSTICS
@@ -992,17 +1223,25 @@ string vault_chance_tag(const map_def &map)
     return "";
 }
 
-typedef vector<unsigned> vault_indices;
-
 static vault_indices _eligible_maps_for_selector(const map_selector &sel)
 {
     vault_indices eligible;
 
     if (sel.valid())
     {
-        for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+#ifdef DEBUG_STATISTICS
+        const auto start = chrono::steady_clock::now();
+#endif
+        vault_indices candidates;
+        sel.candidates(candidates);
+        for (const unsigned i : candidates)
             if (sel.accept(vdefs[i]))
                 eligible.push_back(i);
+#ifdef DEBUG_STATISTICS
+        mapstat_report_map_selection(sel.describe(), candidates.size(),
+            eligible.size(), chrono::duration_cast<chrono::microseconds>(
+                                chrono::steady_clock::now() - start).count());
+#endif
     }
 
     return eligible;
@@ -1272,108 +1511,232 @@ static void _check_des_index_dir()
     checked_des_index_dir = true;
 }
 
-string get_descache_path(const string &file, const string &ext)
+/////////////////////////////////////////////////////////////////////////////
+// The vault cache.
+//
+// Every parsed .des file is stored as one section of a single binary file:
+// its global prelude, the index of its maps and the full map bodies. The
+// file is mapped read-only, so concurrently running games share its pages,
+// and map bodies are read straight out of the mapping when a map is used.
+//
+// The file is never modified in place: when a .des file changes, a new
+// cache is written next to it and renamed over the old one. Processes still
+// using the old file keep their mapping of it.
+//
+// Layout (all integers marshalled):
+//   int32  VAULT_CACHE_MAGIC, save version, byte WORD_LEN
+//   int32  number of sections
+//   for each section: string4 cache name, signed .des mtime,
+//                     int32 offset, int32 length
+//   the sections.
+//
+// A section starts with the int32 offset (within the section) of its index;
+// the map bodies follow, so map_def::cache_offset is never 0. The index is
+// the global prelude (if any), the number of maps, and the index entries.
+
+#define VAULT_CACHE_MAGIC 0x43564344 /* "DCVC" */
+#define VAULT_CACHE_FILE "vaults.bin"
+
+struct vault_cache_section
+{
+    int64_t mtime;
+    const unsigned char *data;
+    size_t length;
+};
+
+class vault_cache
+{
+public:
+    vault_cache() : base(nullptr), size(0) { }
+    ~vault_cache() { unmap(); }
+
+    bool map_file(const string &file);
+    void unmap();
+    const vault_cache_section *find(const string &cache_name) const
+    {
+        return map_find(sections, cache_name);
+    }
+    const map<string, vault_cache_section> &all_sections() const
+    {
+        return sections;
+    }
+
+private:
+    const unsigned char *base;
+    size_t size;
+#ifndef UNIX
+    vector<unsigned char> contents; // no mmap(); keep a private copy
+#endif
+    map<string, vault_cache_section> sections;
+};
+
+void vault_cache::unmap()
 {
-    const string basename = change_file_extension(get_base_filename(file), ext);
-    return _des_cache_dir(basename);
+#ifdef UNIX
+    if (base)
+        munmap(const_cast<unsigned char *>(base), size);
+#else
+    contents.clear();
+#endif
+    base = nullptr;
+    size = 0;
+    sections.clear();
 }
 
-static bool verify_file_version(const string &file, time_t mtime)
+bool vault_cache::map_file(const string &file)
 {
+    unmap();
+
     FILE *fp = fopen_u(file.c_str(), "rb");
     if (!fp)
         return false;
+    const size_t len = file_size(fp);
+#ifdef UNIX
+    void *mem = len ? mmap(nullptr, len, PROT_READ, MAP_SHARED, fileno(fp), 0)
+                    : MAP_FAILED;
+    fclose(fp);
+    if (mem == MAP_FAILED)
+        return false;
+    base = static_cast<const unsigned char *>(mem);
+#else
+    contents.resize(len);
+    const bool ok = len && fread(contents.data(), 1, len, fp) == len;
+    fclose(fp);
+    if (!ok)
+        return false;
+    base = contents.data();
+#endif
+    size = len;
+
+    reader inf(base, size, TAG_MINOR_VERSION);
+    inf.set_safe_read(true);
     try
     {
-        reader inf(fp);
+        const uint32_t magic = unmarshallInt(inf);
         const auto version = get_save_version(inf);
-        const auto major = version.major, minor = version.minor;
         const int8_t word = unmarshallByte(inf);
-        const int64_t t = unmarshallSigned(inf);
-        fclose(fp);
-        return major == TAG_MAJOR_VERSION
-               && minor <= TAG_MINOR_VERSION
-               && word == WORD_LEN
-               && t == mtime;
+        if (magic != VAULT_CACHE_MAGIC
+            || version.major != TAG_MAJOR_VERSION
+            || version.minor > TAG_MINOR_VERSION
+            || word != WORD_LEN)
+        {
+            unmap();
+            return false;
+        }
+
+        const int nsections = unmarshallInt(inf);
+        for (int i = 0; i < nsections; ++i)
+        {
+            string name;
+            unmarshallString4(inf, name);
+            vault_cache_section section;
+            section.mtime = unmarshallSigned(inf);
+            const size_t offset = unmarshallInt(inf);
+            section.length = unmarshallInt(inf);
+            if (offset > size || section.length > size - offset)
+                throw short_read_exception();
+            section.data = base + offset;
+            sections[name] = section;
+        }
     }
     catch (short_read_exception &E)
     {
-        fclose(fp);
+        unmap();
         return false;
     }
+    return true;
 }
 
-static bool _verify_map_index(const string &base, time_t mtime)
+static vault_cache mapped_vaults;
+static bool mapped_vaults_tried = false;
+
+// Sections parsed by this process that aren't in the mapped cache yet.
+struct pending_vault_section
+{
+    int64_t mtime;
+    vector<unsigned char> data;
+};
+static map<string, pending_vault_section> pending_vaults;
+
+// Whether read_map() should leave writing the cache to read_maps().
+static bool batch_map_reads = false;
+
+static string _vault_cache_file()
 {
-    return verify_file_version(base + ".idx", mtime);
+    return _des_cache_dir(VAULT_CACHE_FILE);
 }
 
-static bool _verify_map_full(const string &base, time_t mtime)
+static void _map_vault_cache()
 {
-    return verify_file_version(base + ".dsc", mtime);
+    if (mapped_vaults_tried)
+        return;
+    mapped_vaults_tried = true;
+    mapped_vaults.map_file(_vault_cache_file());
+}
+
+/**
+ * Find the vault cache section for a .des file, so map bodies can be read
+ * from it.
+ *
+ * @param cache_name The cache name of the .des file.
+ * @param[out] data, length The section.
+ * @return false if the section isn't in the cache.
+ */
+bool find_vault_cache_section(const string &cache_name,
+                              const unsigned char *&data, size_t &length)
+{
+    if (pending_vault_section *pending = map_find(pending_vaults, cache_name))
+    {
+        data = pending->data.data();
+        length = pending->data.size();
+        return true;
+    }
+    if (const vault_cache_section *section = mapped_vaults.find(cache_name))
+    {
+        data = section->data;
+        length = section->length;
+        return true;
+    }
+    return false;
 }
 
-static bool _load_map_index(const string& cache, const string &base,
-                            time_t mtime)
+static bool _load_map_section(const string &cache, const unsigned char *data,
+                              size_t length)
 {
-    // If there's a global prelude, load that first.
-    if (FILE *fp = fopen_u((base + ".lux").c_str(), "rb"))
+    reader inf(data, length, TAG_MINOR_VERSION);
+    inf.set_safe_read(true);
+    try
     {
-        reader inf(fp, TAG_MINOR_VERSION);
-        const auto version = get_save_version(inf);
-        const auto major = version.major, minor = version.minor;
-        int8_t word = unmarshallByte(inf);
-        int64_t t = unmarshallSigned(inf);
-        if (major != TAG_MAJOR_VERSION || minor > TAG_MINOR_VERSION
-            || word != WORD_LEN || t != mtime)
+        const int index_offset = unmarshallInt(inf);
+        inf.advance(index_offset - sizeof(int32_t));
+
+        // If there's a global prelude, load that first.
+        if (unmarshallBoolean(inf))
         {
-            return false;
+            lc_global_prelude.read(inf);
+            global_preludes.push_back(lc_global_prelude);
         }
 
-        lc_global_prelude.read(inf);
-        fclose(fp);
-
-        global_preludes.push_back(lc_global_prelude);
+        const int nmaps = unmarshallShort(inf);
+        const int nexist = vdefs.size();
+        vdefs.resize(nexist + nmaps, map_def());
+        _invalidate_map_index();
+        for (int i = 0; i < nmaps; ++i)
+        {
+            map_def &vdef(vdefs[nexist + i]);
+            vdef.read_index(inf);
+            vdef.description = unmarshallString(inf);
+            vdef.order = unmarshallInt(inf);
+
+            vdef.set_file(cache);
+            lc_loaded_maps[vdef.name] = vdef.place_loaded_from;
+            vdef.place_loaded_from.clear();
+        }
     }
-
-    FILE* fp = fopen_u((base + ".idx").c_str(), "rb");
-    if (!fp)
-        end(1, true, "Unable to read %s", (base + ".idx").c_str());
-
-    reader inf(fp, TAG_MINOR_VERSION);
-    // Re-check version, might have been modified in the meantime.
-    const auto version = get_save_version(inf);
-    const auto major = version.major, minor = version.minor;
-    int8_t word = unmarshallByte(inf);
-    int64_t t = unmarshallSigned(inf);
-    if (major != TAG_MAJOR_VERSION || minor > TAG_MINOR_VERSION
-        || word != WORD_LEN || t != mtime)
+    catch (short_read_exception &E)
     {
         return false;
     }
-
-#if TAG_MAJOR_VERSION == 34
-    // Throw out indices that could have CHANCE priority entirely.
-    if (minor < TAG_MINOR_NO_PRIORITY)
-        return false;
-#endif
-
-    const int nmaps = unmarshallShort(inf);
-    const int nexist = vdefs.size();
-    vdefs.resize(nexist + nmaps, map_def());
-    for (int i = 0; i < nmaps; ++i)
-    {
-        map_def &vdef(vdefs[nexist + i]);
-        vdef.read_index(inf);
-        vdef.description = unmarshallString(inf);
-        vdef.order = unmarshallInt(inf);
-
-        vdef.set_file(cache);
-        lc_loaded_maps[vdef.name] = vdef.place_loaded_from;
-        vdef.place_loaded_from.clear();
-    }
-    fclose(fp);
-
     return true;
 }
 
@@ -1383,71 +1746,39 @@ static bool _load_map_cache(const string &filename, const string &cachename)
     if (!crawl_state.use_des_cache)
         return false;
 
-    const string descache_base = get_descache_path(cachename, "");
-
-    file_lock deslock(descache_base + ".lk", "rb", false);
-
-    time_t mtime = file_modtime(filename);
-    string file_idx = descache_base + ".idx";
-    string file_dsc = descache_base + ".dsc";
-
-    // What's the point in checking these twice (here and in load_ma_index)?
-    if (!_verify_map_index(descache_base, mtime)
-        || !_verify_map_full(descache_base, mtime))
-    {
+    _map_vault_cache();
+    const vault_cache_section *section = mapped_vaults.find(cachename);
+    if (!section || section->mtime != file_modtime(filename))
         return false;
-    }
 
-    return _load_map_index(cachename, descache_base, mtime);
-}
-
-static void _write_map_prelude(const string &filebase, time_t mtime)
-{
-    const string luafile = filebase + ".lux";
-    if (lc_global_prelude.empty())
+    const size_t nexist = vdefs.size();
+    if (!_load_map_section(cachename, section->data, section->length))
     {
-        unlink_u(luafile.c_str());
-        return;
+        vdefs.resize(nexist);
+        _invalidate_map_index();
+        return false;
     }
-
-    FILE *fp = fopen_u(luafile.c_str(), "wb");
-    writer outf(luafile, fp);
-    write_save_version(outf, save_version::current());
-    marshallByte(outf, WORD_LEN);
-    marshallSigned(outf, mtime);
-    lc_global_prelude.write(outf);
-    fclose(fp);
+    return true;
 }
 
-static void _write_map_full(const string &filebase, size_t vs, size_t ve,
-                            time_t mtime)
+// Serialise the maps vdefs[vs..ve) parsed from one .des file, and strip
+// them down to their index.
+static vector<unsigned char> _write_map_section(size_t vs, size_t ve)
 {
-    const string cfile = filebase + ".dsc";
-    FILE *fp = fopen_u(cfile.c_str(), "wb");
-    if (!fp)
-        end(1, true, "Unable to open %s for writing", cfile.c_str());
-
-    writer outf(cfile, fp);
-    write_save_version(outf, save_version::current());
-    marshallByte(outf, WORD_LEN);
-    marshallSigned(outf, mtime);
+    vector<unsigned char> section;
+    writer outf(&section);
+    marshallInt(outf, 0); // index offset, filled in below
     for (size_t i = vs; i < ve; ++i)
         vdefs[i].write_full(outf);
-    fclose(fp);
-}
 
-static void _write_map_index(const string &filebase, size_t vs, size_t ve,
-                             time_t mtime)
-{
-    const string cfile = filebase + ".idx";
-    FILE *fp = fopen_u(cfile.c_str(), "wb");
-    if (!fp)
-        end(1, true, "Unable to open %s for writing", cfile.c_str());
+    vector<unsigned char> index_offset;
+    writer offf(&index_offset);
+    marshallInt(offf, section.size());
+    copy(index_offset.begin(), index_offset.end(), section.begin());
 
-    writer outf(cfile, fp);
-    write_save_version(outf, save_version::current());
-    marshallByte(outf, WORD_LEN);
-    marshallSigned(outf, mtime);
+    marshallBoolean(outf, !lc_global_prelude.empty());
+    if (!lc_global_prelude.empty())
+        lc_global_prelude.write(outf);
     marshallShort(outf, ve > vs? ve - vs : 0);
     for (size_t i = vs; i < ve; ++i)
     {
@@ -1457,21 +1788,91 @@ static void _write_map_index(const string &filebase, size_t vs, size_t ve,
         vdefs[i].place_loaded_from.clear();
         vdefs[i].strip();
     }
-    fclose(fp);
+    return section;
 }
 
-static void _write_map_cache(const string &filename, size_t vs, size_t ve,
-                             time_t mtime)
+static void _marshall_vault_directory(writer &outf,
+                                      const map<string, pair<int64_t,
+                                            pair<const unsigned char *,
+                                                 size_t>>> &sections,
+                                      size_t data_start)
 {
+    marshallInt(outf, VAULT_CACHE_MAGIC);
+    write_save_version(outf, save_version::current());
+    marshallByte(outf, WORD_LEN);
+    marshallInt(outf, sections.size());
+    size_t offset = data_start;
+    for (const auto &entry : sections)
+    {
+        marshallString4(outf, entry.first);
+        marshallSigned(outf, entry.second.first);
+        marshallInt(outf, offset);
+        marshallInt(outf, entry.second.second.second);
+        offset += entry.second.second.second;
+    }
+}
+
+// Write out a new vault cache with the sections parsed by this process,
+// keeping the sections of the old cache that are still current, and map it.
+static void _write_vault_cache()
+{
+    if (pending_vaults.empty())
+        return;
+
     _check_des_index_dir();
+    _map_vault_cache();
 
-    const string descache_base = get_descache_path(filename, "");
+    // name -> (mtime, (data, length))
+    map<string, pair<int64_t, pair<const unsigned char *, size_t>>> sections;
+    for (const auto &entry : mapped_vaults.all_sections())
+    {
+        sections[entry.first] = make_pair(entry.second.mtime,
+                                          make_pair(entry.second.data,
+                                                    entry.second.length));
+    }
+    for (const auto &entry : pending_vaults)
+    {
+        sections[entry.first] = make_pair(entry.second.mtime,
+                                          make_pair(entry.second.data.data(),
+                                                    entry.second.data.size()));
+    }
 
-    file_lock deslock(descache_base + ".lk", "wb");
+    // Offsets in the directory are all fixed size, so the directory is as
+    // long with the real offsets as with dummy ones.
+    vector<unsigned char> directory;
+    {
+        writer outf(&directory);
+        _marshall_vault_directory(outf, sections, 0);
+    }
+    const size_t data_start = directory.size();
+    directory.clear();
+    {
+        writer outf(&directory);
+        _marshall_vault_directory(outf, sections, data_start);
+    }
+
+    const string cache_file = _vault_cache_file();
+    const string tmp_file = make_stringf("%s.%d.tmp", cache_file.c_str(),
+                                         (int) getpid());
+    FILE *fp = fopen_replace(tmp_file.c_str());
+    if (!fp)
+        end(1, true, "Unable to open %s for writing", tmp_file.c_str());
 
-    _write_map_prelude(descache_base, mtime);
-    _write_map_full(descache_base, vs, ve, mtime);
-    _write_map_index(descache_base, vs, ve, mtime);
+    writer outf(tmp_file, fp);
+    outf.write(directory.data(), directory.size());
+    for (const auto &entry : sections)
+        outf.write(entry.second.second.first, entry.second.second.second);
+    fclose(fp);
+
+    if (rename_u(tmp_file.c_str(), cache_file.c_str()))
+    {
+        unlink_u(tmp_file.c_str());
+        // Keep using the sections we have in memory.
+        return;
+    }
+
+    if (mapped_vaults.map_file(cache_file))
+        pending_vaults.clear();
 }
 
 static void _parse_maps(const string &s)
@@ -1508,21 +1909,164 @@ static void _parse_maps(const string &s)
 
     global_preludes.push_back(lc_global_prelude);
 
-    _write_map_cache(cache_name, file_start, vdefs.size(), mtime);
+    pending_vault_section &section = pending_vaults[cache_name];
+    section.mtime = mtime;
+    section.data = _write_map_section(file_start, vdefs.size());
 }
 
+// When set, read_map() only lists the files it is asked to read.
+static vector<string> *des_files_listed = nullptr;
+
 void read_map(const string &file)
 {
+    if (des_files_listed)
+    {
+        des_files_listed->push_back(file);
+        return;
+    }
+
     _parse_maps(lc_desfile = datafile_path(file));
+    if (!batch_map_reads)
+        _write_vault_cache();
     _dgn_flush_map_environments();
     // Force GC to prevent heap from swelling unnecessarily.
     dlua.gc();
 }
 
+#ifdef UNIX
+// Named after the parent's pid, so that concurrent -builddb runs don't
+// collide; the parent names the files before forking, since getpid() in the
+// worker would give the worker's own pid.
+static string _des_worker_file(pid_t parent, int worker)
+{
+    return _des_cache_dir(make_stringf("vaults.%d.%d.tmp", (int) parent,
+                                       worker));
+}
+
+static void _write_pending_sections(const string &file)
+{
+    FILE *fp = fopen_replace(file.c_str());
+    if (!fp)
+        end(1, true, "Unable to open %s for writing", file.c_str());
+    writer outf(file, fp);
+    marshallInt(outf, pending_vaults.size());
+    for (const auto &entry : pending_vaults)
+    {
+        marshallString4(outf, entry.first);
+        marshallSigned(outf, entry.second.mtime);
+        marshallInt(outf, entry.second.data.size());
+        outf.write(entry.second.data.data(), entry.second.data.size());
+    }
+    fclose(fp);
+}
+
+static bool _read_pending_sections(const string &file)
+{
+    FILE *fp = fopen_u(file.c_str(), "rb");
+    if (!fp)
+        return false;
+    reader inf(fp);
+    inf.set_safe_read(true);
+    try
+    {
+        const int nsections = unmarshallInt(inf);
+        for (int i = 0; i < nsections; ++i)
+        {
+            string name;
+            unmarshallString4(inf, name);
+            pending_vault_section &section = pending_vaults[name];
+            section.mtime = unmarshallSigned(inf);
+            section.data.resize(unmarshallInt(inf));
+            inf.read(section.data.data(), section.data.size());
+        }
+    }
+    catch (short_read_exception &E)
+    {
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    return true;
+}
+
+/**
+ * Compile the .des files on SysEnv.jobs worker processes, each with its own
+ * parser and Lua state, and merge what they compiled into the vault cache.
+ *
+ * Files are dealt out round-robin in load order. The cache is written with
+ * its sections sorted by name, so its contents don't depend on which worker
+ * compiled what. If a worker fails -- for instance because one of its files
+ * relies on a global prelude from a file another worker compiled -- its
+ * files are left for the sequential pass in read_maps(), which reports any
+ * real errors as usual.
+ */
+static void _compile_des_files_in_parallel()
+{
+    vector<string> files;
+    {
+        unwind_var<vector<string> *> list(des_files_listed, &files);
+        if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
+            end(1, false, "Lua error: %s", dlua.error.c_str());
+    }
+
+    const int jobs = min<int>(SysEnv.jobs, files.size());
+    if (jobs < 2)
+        return;
+
+    _check_des_index_dir();
+    vector<string> worker_files;
+    for (int w = 0; w < jobs; ++w)
+        worker_files.push_back(_des_worker_file(getpid(), w));
+
+    vector<pid_t> workers;
+    for (int w = 0; w < jobs; ++w)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            unwind_bool batch(batch_map_reads, true);
+            for (size_t i = w; i < files.size(); i += jobs)
+                _parse_maps(lc_desfile = datafile_path(files[i]));
+            _write_pending_sections(worker_files[w]);
+            _exit(0);
+        }
+        if (pid < 0)
+            break;
+        workers.push_back(pid);
+    }
+
+    for (int w = 0; w < (int) workers.size(); ++w)
+    {
+        int status = 0;
+        waitpid(workers[w], &status, 0);
+        const string &file = worker_files[w];
+        if (WIFEXITED(status) && !WEXITSTATUS(status))
+            _read_pending_sections(file);
+        unlink_u(file.c_str());
+    }
+
+    _write_vault_cache();
+    // Everything the workers compiled is current now; only rebuild what
+    // they couldn't.
+    crawl_state.use_des_cache = true;
+}
+#endif
+
 void read_maps()
 {
-    if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
-        end(1, false, "Lua error: %s", dlua.error.c_str());
+#ifdef UNIX
+    if (crawl_state.build_db && SysEnv.jobs > 1)
+        _compile_des_files_in_parallel();
+#endif
+
+    {
+        unwind_bool batch(batch_map_reads, true);
+        if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
+            end(1, false, "Lua error: %s", dlua.error.c_str());
+    }
+    _write_vault_cache();
 
     lc_loaded_maps.clear();
 
@@ -1547,6 +2091,7 @@ void reread_maps()
 
     // BOOM!
     vdefs.clear();
+    _invalidate_map_index();
     map_files_read.clear();
     read_maps();
 }
@@ -1566,6 +2111,7 @@ void add_parsed_map(const map_def &md)
 
     map.fixup();
     vdefs.push_back(map);
+    _invalidate_map_index();
 }
 
 void run_map_global_preludes()
@@ -1594,6 +2140,8 @@ void run_map_local_preludes()
             }
         }
     }
+    // Preludes may change tags or depths.
+    _invalidate_map_index();
 }
 
 const map_def *map_by_index(int index)
@@ -60,7 +60,8 @@ void reread_maps();
 void read_map(const string &file);
 void run_map_global_preludes();
 void run_map_local_preludes();
-string get_descache_path(const string &file, const string &ext);
+bool find_vault_cache_section(const string &cache_name,
+                              const unsigned char *&data, size_t &length);
 
 typedef map<string, map_file_place> map_load_info_t;
 
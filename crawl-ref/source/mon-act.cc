@@ -11,6 +11,7 @@
 #include "areas.h"
 #include "arena.h"
 #include "attitude-change.h"
+#include "beam.h"
 #include "bloodspatter.h"
 #include "cloud.h"
 #include "colour.h"
@@ -1749,6 +1750,8 @@ void handle_monster_move(monster* mons)
     if (!mons->has_action_energy())
         return;
 
+    tracer_cache_new_turn();
+
     if (!disabled)
         move_solo_tentacle(mons);
 
@@ -2431,6 +2434,91 @@ static void _display_just_seen()
     mons_reset_just_seen();
 }
 
+// Dormant monsters
+//
+// A monster that is asleep (or can't move), unhurt, free of enchantments and
+// well away from the player has nothing to do on its turn, so
+// handle_monsters() leaves it alone until something disturbs it: an
+// event aimed at it (noise, being attacked), a new enchantment, damage, a
+// cloud or the player coming near. Those clear monster::dormant, and the
+// monster is handled as usual from the next turn on.
+
+/// Is there anything on the level that may affect even a dormant monster?
+static bool _dormancy_allowed()
+{
+    return !crawl_state.game_is_arena()
+        && !(env.level_state & (LSTATE_SLIMY_WALL | LSTATE_ICY_WALL))
+        && !have_passive(passive_t::neutral_slimes)
+        && !have_passive(passive_t::friendly_plants);
+}
+
+/// Would this monster's turn change nothing, until something disturbs it?
+static bool _mons_can_be_dormant(const monster &mons)
+{
+    if (mons.attitude != ATT_HOSTILE
+        || !(mons.asleep() && mons.foe == MHITNOT
+             && mons.target == mons.pos()
+             || mons.speed == 0)
+        || !mons.enchantments.empty()
+        || mons.hit_points != mons.max_hit_points
+        || mons.foe_memory > 0
+        || testbits(mons.flags, MF_JUST_SUMMONED)
+        || mons.is_constricted()
+        || mons.is_constricting()
+        || mons_stores_tracking_data(mons)
+        || mons_is_projectile(mons)
+        || mons_is_tentacle_or_tentacle_segment(mons.type))
+    {
+        return false;
+    }
+
+    // Monsters with something of their own to do every turn.
+    switch (mons.type)
+    {
+    case MONS_SPATIAL_MAELSTROM:
+    case MONS_SNAPLASHER_VINE:
+    case MONS_BALL_LIGHTNING:
+    case MONS_FOXFIRE:
+    case MONS_BATTLESPHERE:
+    case MONS_BLAZEHEART_GOLEM:
+    case MONS_SHAPESHIFTER:
+    case MONS_GLOWING_SHAPESHIFTER:
+    case MONS_TIAMAT:
+    case MONS_JEREMIAH:
+    case MONS_SIXFIRHY:
+    case MONS_JIANGSHI:
+        return false;
+    default:
+        break;
+    }
+
+    return grid_distance(mons.pos(), you.pos()) > LOS_RADIUS
+           && !cloud_at(mons.pos())
+           && env.grid(mons.pos()) != DNGN_TOXIC_BOG;
+}
+
+/// Wake the monsters an actor's move may concern: the actor itself, or
+/// those near the player's new position.
+void dormant_actor_moved(actor *act)
+{
+    if (act->is_monster())
+    {
+        act->as_monster()->dormant = false;
+        return;
+    }
+
+    for (monster_radius_iterator mi(act->pos(), LOS_RADIUS); mi; ++mi)
+        mi->dormant = false;
+}
+
+/// Wake any monster standing in a cloud.
+static void _wake_clouded_monsters()
+{
+    for (const auto &entry : env.cloud)
+        if (monster *mons = monster_at(entry.first))
+            mons->dormant = false;
+}
+
 /**
  * Get all monsters to make an action, if they can/want to.
  *
@@ -2438,8 +2526,27 @@ static void _display_just_seen()
  */
 void handle_monsters(bool with_noise)
 {
+    const bool allow_dormant = _dormancy_allowed();
+    _wake_clouded_monsters();
+
     for (monster_iterator mi; mi; ++mi)
     {
+        if (mi->dormant && allow_dormant)
+        {
+#ifdef DEBUG_MONS_SCAN
+            if (!_mons_can_be_dormant(**mi))
+            {
+                mprf(MSGCH_ERROR, "Dormant monster %s was disturbed without "
+                                  "waking up",
+                     mi->name(DESC_PLAIN, true).c_str());
+            }
+#endif
+            continue;
+        }
+        mi->dormant = allow_dormant && _mons_can_be_dormant(**mi);
+        if (mi->dormant)
+            continue;
+
         _pre_monster_move(**mi);
         if (!invalid_monster(*mi) && mi->alive() && mi->has_action_energy())
             monster_queue.emplace(*mi, mi->speed_increment);
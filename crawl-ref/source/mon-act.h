@@ -11,6 +11,7 @@
 
 using std::pair;
 
+class actor;
 class monster;
 struct bolt;
 
@@ -33,6 +34,7 @@ bool handle_throw(monster* mons, bolt &beem, bool teleport, bool check_only);
 
 void handle_monsters(bool with_noise = false);
 void handle_monster_move(monster* mon);
+void dormant_actor_moved(actor *act);
 
 void queue_monster_for_action(monster* mons);
 
@@ -963,6 +963,8 @@ void behaviour_event(monster* mon, mon_event_type event, const actor *src,
     if (!mon->alive())
         return;
 
+    mon->dormant = false;
+
     ASSERT(!crawl_state.game_is_arena() || src != &you);
     ASSERT_IN_BOUNDS_OR_ORIGIN(src_pos);
     if (mons_is_projectile(mon->type))
@@ -3251,6 +3251,7 @@ void end_flayed_effect(monster* ghost)
 void monster_cleanup(monster* mons)
 {
     crawl_state.mon_gone(mons);
+    clear_tracer_cache();
 
     ASSERT(mons->type != MONS_NO_MONSTER);
 
@@ -164,6 +164,8 @@ void monster::update_ench(const mon_enchant &ench)
 
 bool monster::add_ench(const mon_enchant &ench)
 {
+    dormant = false;
+
     // silliness
     if (ench.ench == ENCH_NONE)
         return false;
@@ -1753,10 +1755,9 @@ void monster::apply_enchantment(const mon_enchant &me)
     case ENCH_FLAYED:
     {
         bool near_ghost = false;
-        for (monster_iterator mi; mi; ++mi)
+        for (monster_near_iterator mi(pos()); mi; ++mi)
         {
-            if (mi->type == MONS_FLAYED_GHOST && !mons_aligned(this, *mi)
-                && see_cell(mi->pos()))
+            if (mi->type == MONS_FLAYED_GHOST && !mons_aligned(this, *mi))
             {
                 near_ghost = true;
                 break;
@@ -211,12 +211,23 @@ bool try_pathfind(monster* mon)
          mon->name(DESC_PLAIN).c_str(), mon->pos().x, mon->pos().y,
          targpos.x, targpos.y, range);
 #endif
-    monster_pathfind mp;
-    mp.set_range(range);
+    // Hostiles chasing the player share distance fields; everyone else
+    // runs their own search.
+    vector<coord_def> waypoints;
+    maybe_bool found = shared_pathfind(mon, targpos, range, waypoints);
+    if (found == maybe_bool::maybe)
+    {
+        monster_pathfind mp;
+        mp.set_range(range);
 
-    if (mp.init_pathfind(mon, targpos))
+        found = mp.init_pathfind(mon, targpos);
+        if (found)
+            waypoints = mp.calc_waypoints();
+    }
+
+    if (found)
     {
-        mon->travel_path = mp.calc_waypoints();
+        mon->travel_path = waypoints;
         if (!mon->travel_path.empty())
         {
             // Okay then, we found a path. Let's use it!
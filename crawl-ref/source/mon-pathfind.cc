@@ -2,12 +2,20 @@
 
 #include "mon-pathfind.h"
 
+#include <bitset>
+#include <queue>
+
+#include "areas.h"
+#include "coordit.h"
 #include "directn.h"
 #include "env.h"
 #include "los.h"
+#include "losglobal.h"
+#include "mapmark.h"
 #include "misc.h"
 #include "mon-movetarget.h"
 #include "mon-place.h"
+#include "mon-util.h"
 #include "religion.h"
 #include "state.h"
 #include "terrain.h"
@@ -63,7 +71,8 @@ int mons_tracking_range(const monster* mon)
 //#define DEBUG_PATHFIND
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
-      traverse_unmapped(false), range(0), min_length(0), max_length(0),
+      traverse_unmapped(false), range(0), cluster_search(true),
+      expansions(0), cluster_path(), min_length(0), max_length(0),
       dist(), prev(), hash(), traversable_cache()
 {
 }
@@ -78,6 +87,16 @@ void monster_pathfind::set_range(int r)
         range = r;
 }
 
+void monster_pathfind::set_cluster_search(bool clusters)
+{
+    cluster_search = clusters;
+}
+
+int monster_pathfind::nodes_expanded() const
+{
+    return expansions;
+}
+
 coord_def monster_pathfind::next_pos(const coord_def &c) const
 {
     return c + Compass[prev[c.x][c.y]];
@@ -98,6 +117,8 @@ bool monster_pathfind::init_pathfind(const monster* mon, coord_def dest,
     traverse_in_sight = (!crawl_state.game_is_arena()
                          && mon->friendly() &&  mon->is_summoned()
                          && you.see_cell_no_trans(mon->pos()));
+    expansions = 0;
+    cluster_path.clear();
 
     // Easy enough. :P
     if (start == target)
@@ -108,6 +129,9 @@ bool monster_pathfind::init_pathfind(const monster* mon, coord_def dest,
         return true;
     }
 
+    if (cluster_search && cluster_pathfind())
+        return true;
+
     return start_pathfind(msg);
 }
 
@@ -119,6 +143,8 @@ bool monster_pathfind::init_pathfind(coord_def src, coord_def dest, bool doors,
     pos    = start;
     allow_diagonals = diag;
     traverse_doors = doors;
+    expansions = 0;
+    cluster_path.clear();
 
     // Easy enough. :P
     if (start == target)
@@ -297,6 +323,7 @@ bool monster_pathfind::get_best_position()
             // likely to be close to the target.
             pos = vec[vec.size()-1];
             vec.pop_back();
+            expansions++;
 
 #ifdef DEBUG_PATHFIND
             mprf("Returning (%d, %d) as best pos with total dist %d.",
@@ -321,6 +348,9 @@ vector<coord_def> monster_pathfind::backtrack()
 #ifdef DEBUG_PATHFIND
     mpr("Backtracking...");
 #endif
+    if (!cluster_path.empty())
+        return cluster_path;
+
     vector<coord_def> path;
     pos = target;
     path.push_back(pos);
@@ -356,24 +386,28 @@ vector<coord_def> monster_pathfind::backtrack()
 // This is done because Crawl's pathfinding - once a target is in sight and easy
 // reach - is both very robust and natural, especially if we want to flexibly
 // avoid plants and other monsters in the way.
-vector<coord_def> monster_pathfind::calc_waypoints()
+static vector<coord_def> _path_waypoints(const monster* mons,
+                                         const vector<coord_def> &path,
+                                         bool in_sight)
 {
-    vector<coord_def> path = backtrack();
+    vector<coord_def> waypoints;
 
     // If no path found, nothing to be done.
     if (path.empty())
-        return path;
+        return waypoints;
 
-    vector<coord_def> waypoints;
-    pos = path[0];
+    coord_def pos = path[0];
 
 #ifdef DEBUG_PATHFIND
     mpr("\nWaypoints:");
 #endif
     for (unsigned int i = 1; i < path.size(); i++)
     {
-        if (can_go_straight(mons, pos, path[i]) && mons_traversable(path[i]))
+        if (can_go_straight(mons, pos, path[i])
+            && mons_can_traverse(*mons, path[i], in_sight))
+        {
             continue;
+        }
         else
         {
             pos = path[i-1];
@@ -393,6 +427,11 @@ vector<coord_def> monster_pathfind::calc_waypoints()
     return waypoints;
 }
 
+vector<coord_def> monster_pathfind::calc_waypoints()
+{
+    return _path_waypoints(mons, backtrack(), traverse_in_sight);
+}
+
 bool monster_pathfind::traversable_memoized(const coord_def& p)
 {
     if (traversable_cache[p.x][p.y] == maybe_bool::maybe)
@@ -518,3 +557,758 @@ void monster_pathfind::update_pos(coord_def npos, int total)
 
     add_new_pos(npos, total);
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// Shared distance fields
+//
+// When many hostiles chase the player, each of them running its own A*
+// repeats nearly the same search. Instead, monsters that move the same way
+// share a distance field flooded outward from the player once per turn,
+// and read their path off it by walking downhill. The field covers the same
+// cells and uses the same costs as monster_pathfind would, so the paths
+// have the same length; only ties may be broken differently.
+//
+// Only hostile monsters heading for the player use these: for them, moving
+// depends on the terrain and on a few fixed properties of the monster, which
+// make up the field's key. Everything else falls back to monster_pathfind.
+
+// How a monster moves, as far as the shared fields are concerned.
+struct path_field_key
+{
+    bitset<NUM_FEATURES> habitable;
+    bitset<NUM_FEATURES> flounders;
+    bool grounded;
+    bool doors;
+    int range;
+
+    bool operator == (const path_field_key &other) const
+    {
+        return habitable == other.habitable && flounders == other.flounders
+               && grounded == other.grounded && doors == other.doors
+               && range == other.range;
+    }
+};
+
+static path_field_key _path_field_key(const monster &mon, int range)
+{
+    path_field_key key;
+    for (int feat = 0; feat < NUM_FEATURES; ++feat)
+    {
+        const dungeon_feature_type grid = (dungeon_feature_type) feat;
+        key.habitable[feat] = mon.is_habitable_feat(grid);
+        key.flounders[feat] = mon.flounders_in(grid);
+    }
+    key.grounded = mon.ground_level();
+    key.doors = mons_can_pass_doors(mon);
+    key.range = range;
+    return key;
+}
+
+// Distances to the target from every cell within range of it.
+struct path_field
+{
+    path_field_key key;
+    coord_def target;
+    // The top left corner and size of the cells covered.
+    coord_def corner;
+    int width, height;
+    vector<int> dist;
+    // The cost of entering each cell; 0 if the monster can't enter it.
+    vector<uint8_t> cost;
+
+    bool covers(const coord_def &p) const
+    {
+        return p.x >= corner.x && p.x < corner.x + width
+               && p.y >= corner.y && p.y < corner.y + height;
+    }
+
+    int index(const coord_def &p) const
+    {
+        return (p.y - corner.y) * width + p.x - corner.x;
+    }
+
+    void flood();
+};
+
+// The cost for a monster with this key to enter p, following
+// monster_pathfind::traversable() and mons_travel_cost() for a hostile.
+static int _field_cost(const path_field_key &key, const coord_def &p)
+{
+    const dungeon_feature_type grid = env.grid(p);
+    const bool door = feat_is_closed_door(grid);
+
+    if (door)
+        return 2;
+    if (key.grounded && (liquefied(p) || key.flounders[grid]))
+        return 2;
+    if (const trap_def* ptrap = trap_at(p))
+        return ptrap->is_bad_for_player() ? 1 : 2;
+    return 1;
+}
+
+static bool _field_traversable(const path_field_key &key, const coord_def &p)
+{
+    const dungeon_feature_type grid = env.grid(p);
+    const bool door = feat_is_closed_door(grid);
+
+    if (grid == DNGN_UNSEEN || opc_immob(p) == OPC_OPAQUE && !door)
+        return false;
+    if (cell_is_runed(p))
+        return false;
+    if (door && key.doors
+        && env.markers.property_at(p, MAT_ANY, "door_restrict") != "veto")
+    {
+        return true;
+    }
+    // Hostile monsters consider every trap safe.
+    return key.habitable[grid];
+}
+
+// A Dijkstra flood from the target. Costs are small, so the queue is a list
+// of buckets by distance. Like monster_pathfind, give up on paths longer
+// than twice the range.
+void path_field::flood()
+{
+    const int range = key.range;
+    const coord_def last(GXM - 1, GYM - 1);
+    corner = (target - coord_def(range, range)).clamped(coord_def(), last);
+    const coord_def far_corner =
+        (target + coord_def(range, range)).clamped(coord_def(), last);
+    width = far_corner.x - corner.x + 1;
+    height = far_corner.y - corner.y + 1;
+
+    dist.assign(width * height, INFINITE_DISTANCE);
+    cost.assign(width * height, 0);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+        {
+            const coord_def p = corner + coord_def(x, y);
+            if (in_bounds(p) && (p == target || _field_traversable(key, p)))
+                cost[index(p)] = _field_cost(key, p);
+        }
+
+    vector<vector<coord_def>> buckets(2 * range + 1);
+    dist[index(target)] = 0;
+    buckets[0].push_back(target);
+    for (int d = 0; d <= 2 * range; ++d)
+        for (unsigned int i = 0; i < buckets[d].size(); ++i)
+        {
+            const coord_def c = buckets[d][i];
+            const int ci = index(c);
+            if (dist[ci] != d)
+                continue;
+
+            // Coming from a neighbour into c costs entering c.
+            const int nd = d + cost[ci];
+            if (nd > 2 * range)
+                continue;
+            for (int dir = 0; dir < 8; ++dir)
+            {
+                const coord_def n = c + Compass[dir];
+                if (!covers(n))
+                    continue;
+                const int ni = index(n);
+                if (cost[ni] && n != target && nd < dist[ni])
+                {
+                    dist[ni] = nd;
+                    buckets[nd].push_back(n);
+                }
+            }
+        }
+}
+
+static struct
+{
+    int turn = -1;
+    level_id place;
+    unsigned int los_gen = 0;
+    vector<unique_ptr<path_field>> fields;
+} shared_fields;
+
+static const path_field &_shared_field(const path_field_key &key,
+                                       const coord_def &target)
+{
+    // Terrain and the player move between turns; anything that changes
+    // opacity in between invalidates the fields too.
+    if (shared_fields.turn != you.num_turns
+        || shared_fields.place != level_id::current()
+        || shared_fields.los_gen != los_generation())
+    {
+        shared_fields.turn = you.num_turns;
+        shared_fields.place = level_id::current();
+        shared_fields.los_gen = los_generation();
+        shared_fields.fields.clear();
+    }
+
+    for (const auto &field : shared_fields.fields)
+        if (field->target == target && field->key == key)
+            return *field;
+
+    shared_fields.fields.emplace_back(new path_field);
+    path_field &field = *shared_fields.fields.back();
+    field.key = key;
+    field.target = target;
+    field.flood();
+    return field;
+}
+
+/**
+ * Find a path for a monster from the shared distance fields.
+ *
+ * @param mon       The monster.
+ * @param dest      Where it wants to go.
+ * @param range     The range monster_pathfind would be given.
+ * @param waypoints[out] The waypoints of the path, as from
+ *                  monster_pathfind::calc_waypoints().
+ * @return Whether a path was found, or maybe if the shared fields don't
+ *         apply, and monster_pathfind should be used instead.
+ */
+maybe_bool shared_pathfind(const monster* mon, coord_def dest, int range,
+                           vector<coord_def> &waypoints)
+{
+    if (dest != you.pos() || mon->wont_attack() || range <= 0
+        || crawl_state.game_is_arena()
+        // See monster_pathfind::traversable().
+        || mon->type == MONS_THORN_HUNTER)
+    {
+        return maybe_bool::maybe;
+    }
+
+    const coord_def start = mon->pos();
+    if (start == dest || grid_distance(start, dest) > range)
+        return maybe_bool::maybe;
+
+    const path_field &field = _shared_field(_path_field_key(*mon, range),
+                                            dest);
+
+    // Walk downhill from the monster. The monster's own cell may not be
+    // in the field, so always look at the neighbours. As in
+    // monster_pathfind, start with a random rotation and try diagonals
+    // first.
+    const int rotate = random2(4) * 2;
+    vector<coord_def> path(1, start);
+    coord_def pos = start;
+    while (pos != dest)
+    {
+        int best = INFINITE_DISTANCE;
+        coord_def next;
+        for (int idir = 1; idir < 8; (idir += 2) == 9 && (idir = 0))
+        {
+            const coord_def n = pos + Compass[(idir + rotate) % 8];
+            if (!field.covers(n))
+                continue;
+            const int ni = field.index(n);
+            if (!field.cost[ni] || field.dist[ni] == INFINITE_DISTANCE)
+                continue;
+            const int d = field.dist[ni] + field.cost[ni];
+            if (d < best)
+            {
+                best = d;
+                next = n;
+            }
+        }
+
+        if (best == INFINITE_DISTANCE
+            || pos == start && best > 2 * range)
+        {
+            return false;
+        }
+        pos = next;
+        path.push_back(pos);
+    }
+
+    waypoints = _path_waypoints(mon, path, false);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Cluster graph
+//
+// Looking for a distant target, A* ends up expanding most of the level. So
+// the level is also split into square clusters, joined by entrances where
+// neighbouring clusters share open border cells, and for each cluster we
+// keep the travel costs between its entrances. A search over the entrances
+// gives a route through the clusters, which is then refined into single
+// steps using the paths stored with each cluster. Terrain changes only mark
+// the clusters around them for rebuilding.
+//
+// Like the shared fields, this is only used by hostile monsters, and with
+// the same key (minus the range). The refined path is checked against the
+// monster itself and the range limits before it is used; if anything is
+// off, monster_pathfind falls back to plain A*.
+
+#define CLUSTER_SIZE 10
+#define CLUSTER_CELLS (CLUSTER_SIZE * CLUSTER_SIZE)
+// Targets closer than this are left to plain A*.
+#define CLUSTER_SEARCH_DIST 20
+// Open stretches of border at least this long get an entrance at each end,
+// shorter ones a single entrance in the middle.
+#define CLUSTER_WIDE_ENTRANCE 6
+// How many differently moving monsters to keep graphs for.
+#define MAX_CLUSTER_GRAPHS 8
+
+static const int CLUSTERS_X = (GXM + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+static const int CLUSTERS_Y = (GYM + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+static const int NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y;
+
+static int _cluster_at(const coord_def &p)
+{
+    return p.y / CLUSTER_SIZE * CLUSTERS_X + p.x / CLUSTER_SIZE;
+}
+
+static coord_def _cluster_corner(int c)
+{
+    return coord_def(c % CLUSTERS_X, c / CLUSTERS_X) * CLUSTER_SIZE;
+}
+
+// The index of p among the cells of cluster c.
+static int _cluster_cell(int c, const coord_def &p)
+{
+    const coord_def rel = p - _cluster_corner(c);
+    return rel.y * CLUSTER_SIZE + rel.x;
+}
+
+/**
+ * A Dijkstra flood over the cells of one cluster.
+ *
+ * @param key     How the monster moves.
+ * @param c       The cluster.
+ * @param source  Where to start; always treated as open.
+ * @param reverse If false, dist is the cost of getting from source to each
+ *                cell, and prev the direction back towards source. If true,
+ *                dist is the cost of getting from each cell to source, and
+ *                prev the next step towards it.
+ * @param dist[out], prev[out] CLUSTER_CELLS entries each; prev is -1 where
+ *                there is nowhere to go.
+ * @return The number of cells expanded.
+ */
+static int _flood_cluster(const path_field_key &key, int c,
+                          const coord_def &source, bool reverse,
+                          int *dist, int8_t *prev)
+{
+    const coord_def corner = _cluster_corner(c);
+    uint8_t cost[CLUSTER_CELLS];
+    for (int i = 0; i < CLUSTER_CELLS; ++i)
+    {
+        const coord_def p = corner + coord_def(i % CLUSTER_SIZE,
+                                               i / CLUSTER_SIZE);
+        cost[i] = in_bounds(p) && (p == source || _field_traversable(key, p))
+                  ? _field_cost(key, p) : 0;
+        dist[i] = INFINITE_DISTANCE;
+        prev[i] = -1;
+    }
+
+    typedef pair<int, int> queued;
+    priority_queue<queued, vector<queued>, greater<queued>> queue;
+    const int si = _cluster_cell(c, source);
+    dist[si] = 0;
+    queue.emplace(0, si);
+
+    int expanded = 0;
+    while (!queue.empty())
+    {
+        const int d = queue.top().first;
+        const int ci = queue.top().second;
+        queue.pop();
+        if (d != dist[ci])
+            continue;
+
+        expanded++;
+        const coord_def p = corner + coord_def(ci % CLUSTER_SIZE,
+                                               ci / CLUSTER_SIZE);
+        for (int dir = 0; dir < 8; ++dir)
+        {
+            const coord_def n = p + Compass[dir];
+            if (n.x < corner.x || n.x >= corner.x + CLUSTER_SIZE
+                || n.y < corner.y || n.y >= corner.y + CLUSTER_SIZE)
+            {
+                continue;
+            }
+            const int ni = _cluster_cell(c, n);
+            if (!cost[ni])
+                continue;
+            const int nd = d + (reverse ? cost[ci] : cost[ni]);
+            if (nd < dist[ni])
+            {
+                dist[ni] = nd;
+                prev[ni] = (dir + 4) % 8;
+                queue.emplace(nd, ni);
+            }
+        }
+    }
+    return expanded;
+}
+
+// Append the steps from the source of a forward flood to p, excluding the
+// source itself.
+static void _cluster_steps_to(int c, const int8_t *prev, coord_def p,
+                              vector<coord_def> &path)
+{
+    const size_t first = path.size();
+    for (int dir; (dir = prev[_cluster_cell(c, p)]) != -1;
+         p += Compass[dir])
+    {
+        path.push_back(p);
+    }
+    reverse(path.begin() + first, path.end());
+}
+
+// Append the steps from p to the source of a reverse flood, excluding p.
+static void _cluster_steps_from(int c, const int8_t *prev, coord_def p,
+                                vector<coord_def> &path)
+{
+    for (int dir; (dir = prev[_cluster_cell(c, p)]) != -1;)
+    {
+        p += Compass[dir];
+        path.push_back(p);
+    }
+}
+
+struct cluster_entrance
+{
+    coord_def pos;
+    // The entrance of the neighbouring cluster this one leads to.
+    coord_def across;
+};
+
+struct path_cluster
+{
+    bool dirty = true;
+    vector<cluster_entrance> entrances;
+    // The cost from entrance i to entrance j is at i * size + j.
+    vector<int> cost;
+    // Forward flood directions from each entrance, CLUSTER_CELLS apiece.
+    vector<int8_t> prev;
+
+    int entrance_at(const coord_def &p) const
+    {
+        for (unsigned int i = 0; i < entrances.size(); ++i)
+            if (entrances[i].pos == p)
+                return i;
+        return -1;
+    }
+};
+
+struct cluster_graph
+{
+    path_field_key key;
+    path_cluster clusters[NUM_CLUSTERS];
+
+    int update();
+
+private:
+    void find_entrances(int c, coord_def inside, coord_def step,
+                        coord_def out);
+    int build(int c);
+};
+
+// Add entrances along one side of cluster c. The side starts at inside,
+// runs along step, and out points across it. Both clusters sharing a side
+// scan it in the same order, so they agree on where its entrances are.
+void cluster_graph::find_entrances(int c, coord_def inside, coord_def step,
+                                   coord_def out)
+{
+    vector<cluster_entrance> &entrances = clusters[c].entrances;
+    int run = 0;
+    for (int i = 0; i <= CLUSTER_SIZE; ++i)
+    {
+        const coord_def a = inside + step * i;
+        const coord_def b = a + out;
+        if (i < CLUSTER_SIZE
+            && in_bounds(a) && in_bounds(b)
+            && _field_traversable(key, a) && _field_traversable(key, b))
+        {
+            run++;
+            continue;
+        }
+        if (!run)
+            continue;
+
+        const coord_def first = a - step * run;
+        const coord_def last = a - step;
+        if (run < CLUSTER_WIDE_ENTRANCE)
+        {
+            const coord_def mid = first + step * ((run - 1) / 2);
+            entrances.push_back({ mid, mid + out });
+        }
+        else
+        {
+            entrances.push_back({ first, first + out });
+            entrances.push_back({ last, last + out });
+        }
+        run = 0;
+    }
+}
+
+// Rebuild the entrances and costs of cluster c, returning the number of
+// cells expanded doing so.
+int cluster_graph::build(int c)
+{
+    path_cluster &cluster = clusters[c];
+    const coord_def corner = _cluster_corner(c);
+    const coord_def last = corner + coord_def(CLUSTER_SIZE - 1,
+                                             CLUSTER_SIZE - 1);
+    cluster.entrances.clear();
+    find_entrances(c, corner, coord_def(1, 0), coord_def(0, -1));
+    find_entrances(c, coord_def(corner.x, last.y), coord_def(1, 0),
+                   coord_def(0, 1));
+    find_entrances(c, corner, coord_def(0, 1), coord_def(-1, 0));
+    find_entrances(c, coord_def(last.x, corner.y), coord_def(0, 1),
+                   coord_def(1, 0));
+
+    const int size = cluster.entrances.size();
+    cluster.cost.assign(size * size, INFINITE_DISTANCE);
+    cluster.prev.resize(size * CLUSTER_CELLS);
+
+    int expanded = 0;
+    int dist[CLUSTER_CELLS];
+    for (int i = 0; i < size; ++i)
+    {
+        expanded += _flood_cluster(key, c, cluster.entrances[i].pos, false,
+                                   dist, &cluster.prev[i * CLUSTER_CELLS]);
+        for (int j = 0; j < size; ++j)
+        {
+            cluster.cost[i * size + j] =
+                dist[_cluster_cell(c, cluster.entrances[j].pos)];
+        }
+    }
+    cluster.dirty = false;
+    return expanded;
+}
+
+// Rebuild any clusters that have changed, returning the number of cells
+// expanded doing so.
+int cluster_graph::update()
+{
+    int expanded = 0;
+    for (int c = 0; c < NUM_CLUSTERS; ++c)
+        if (clusters[c].dirty)
+            expanded += build(c);
+    return expanded;
+}
+
+static struct
+{
+    level_id place;
+    vector<unique_ptr<cluster_graph>> graphs;
+} cluster_graphs;
+
+static cluster_graph &_cluster_graph(const path_field_key &key)
+{
+    if (cluster_graphs.place != level_id::current())
+    {
+        cluster_graphs.place = level_id::current();
+        cluster_graphs.graphs.clear();
+    }
+
+    for (const auto &graph : cluster_graphs.graphs)
+        if (graph->key == key)
+            return *graph;
+
+    if (cluster_graphs.graphs.size() >= MAX_CLUSTER_GRAPHS)
+        cluster_graphs.graphs.erase(cluster_graphs.graphs.begin());
+    cluster_graphs.graphs.emplace_back(new cluster_graph);
+    cluster_graphs.graphs.back()->key = key;
+    return *cluster_graphs.graphs.back();
+}
+
+/**
+ * Mark the clusters around a cell for rebuilding.
+ *
+ * Whether a cell is open decides the entrances on its side of a border,
+ * and on the other side too, so everything next to it is affected.
+ */
+void cluster_graph_changed(const coord_def &p)
+{
+    for (const auto &graph : cluster_graphs.graphs)
+        for (adjacent_iterator ai(p, false); ai; ++ai)
+            if (in_bounds(*ai))
+                graph->clusters[_cluster_at(*ai)].dirty = true;
+}
+
+void cluster_graph_reset()
+{
+    cluster_graphs.graphs.clear();
+}
+
+/**
+ * Find a path through the cluster graph.
+ *
+ * @param key     How the monster moves.
+ * @param start   Where it is.
+ * @param target  Where it wants to go; this needn't be traversable.
+ * @param path[out] Every step from start to target inclusive.
+ * @param expanded[in,out] Incremented by the number of cells and nodes
+ *                looked at.
+ * @return Whether a path was found.
+ */
+static bool _cluster_path(const path_field_key &key, coord_def start,
+                          coord_def target, vector<coord_def> &path,
+                          int &expanded)
+{
+    cluster_graph &graph = _cluster_graph(key);
+    expanded += graph.update();
+
+    // Number the entrances; the start and target come last.
+    vector<int> offset(NUM_CLUSTERS + 1, 0);
+    for (int c = 0; c < NUM_CLUSTERS; ++c)
+        offset[c + 1] = offset[c] + graph.clusters[c].entrances.size();
+    const int nodes = offset[NUM_CLUSTERS];
+    const int start_node = nodes;
+    const int target_node = nodes + 1;
+    vector<int> node_cluster(nodes);
+    for (int c = 0; c < NUM_CLUSTERS; ++c)
+        for (int i = offset[c]; i < offset[c + 1]; ++i)
+            node_cluster[i] = c;
+
+    auto node_pos = [&](int u) {
+        return u == start_node  ? start :
+               u == target_node ? target
+                                : graph.clusters[node_cluster[u]]
+                                      .entrances[u - offset[node_cluster[u]]]
+                                      .pos;
+    };
+
+    const int start_cluster = _cluster_at(start);
+    const int target_cluster = _cluster_at(target);
+    int start_dist[CLUSTER_CELLS], target_dist[CLUSTER_CELLS];
+    int8_t start_prev[CLUSTER_CELLS], target_prev[CLUSTER_CELLS];
+    expanded += _flood_cluster(key, start_cluster, start, false,
+                               start_dist, start_prev);
+    expanded += _flood_cluster(key, target_cluster, target, true,
+                               target_dist, target_prev);
+
+    // A* over the entrances.
+    vector<int> best(nodes + 2, INFINITE_DISTANCE);
+    vector<int> parent(nodes + 2, -1);
+    vector<bool> done(nodes + 2, false);
+    typedef pair<int, int> queued;
+    priority_queue<queued, vector<queued>, greater<queued>> queue;
+
+    auto relax = [&](int u, int v, int cost) {
+        if (cost == INFINITE_DISTANCE || best[u] + cost >= best[v])
+            return;
+        best[v] = best[u] + cost;
+        parent[v] = u;
+        queue.emplace(best[v] + grid_distance(node_pos(v), target), v);
+    };
+
+    best[start_node] = 0;
+    queue.emplace(grid_distance(start, target), start_node);
+    while (!queue.empty())
+    {
+        const int u = queue.top().second;
+        queue.pop();
+        if (done[u])
+            continue;
+        done[u] = true;
+        if (u == target_node)
+            break;
+        expanded++;
+
+        if (u == start_node)
+        {
+            const path_cluster &cluster = graph.clusters[start_cluster];
+            for (unsigned int i = 0; i < cluster.entrances.size(); ++i)
+            {
+                const coord_def p = cluster.entrances[i].pos;
+                relax(u, offset[start_cluster] + i,
+                      start_dist[_cluster_cell(start_cluster, p)]);
+            }
+            continue;
+        }
+
+        const int c = node_cluster[u];
+        const int i = u - offset[c];
+        const path_cluster &cluster = graph.clusters[c];
+        const int size = cluster.entrances.size();
+        for (int j = 0; j < size; ++j)
+            if (j != i)
+                relax(u, offset[c] + j, cluster.cost[i * size + j]);
+
+        const coord_def across = cluster.entrances[i].across;
+        const int ac = _cluster_at(across);
+        const int j = graph.clusters[ac].entrance_at(across);
+        if (j >= 0)
+            relax(u, offset[ac] + j, _field_cost(key, across));
+
+        if (c == target_cluster)
+        {
+            relax(u, target_node,
+                  target_dist[_cluster_cell(c, cluster.entrances[i].pos)]);
+        }
+    }
+
+    if (!done[target_node])
+        return false;
+
+    vector<int> route;
+    for (int u = target_node; u != -1; u = parent[u])
+        route.push_back(u);
+    reverse(route.begin(), route.end());
+
+    // Refine the route: from the start to the first entrance, between
+    // entrances, and from the last one to the target.
+    path.assign(1, start);
+    _cluster_steps_to(start_cluster, start_prev, node_pos(route[1]), path);
+    for (unsigned int k = 2; k + 1 < route.size(); ++k)
+    {
+        const int from = route[k - 1];
+        const int to = route[k];
+        const int c = node_cluster[from];
+        if (node_cluster[to] != c)
+        {
+            path.push_back(node_pos(to));
+            continue;
+        }
+        const int8_t *prev =
+            &graph.clusters[c].prev[(from - offset[c]) * CLUSTER_CELLS];
+        _cluster_steps_to(c, prev, node_pos(to), path);
+    }
+    _cluster_steps_from(target_cluster, target_prev,
+                        node_pos(route[route.size() - 2]), path);
+    return true;
+}
+
+// Look for a path to a distant target in the cluster graph. If one is found
+// that start_pathfind() could also have returned, store it and return true.
+bool monster_pathfind::cluster_pathfind()
+{
+    if (!mons || mons->wont_attack() || crawl_state.game_is_arena()
+        // See traversable().
+        || mons->type == MONS_THORN_HUNTER
+        || !allow_diagonals || traverse_unmapped || traverse_in_sight
+        || grid_distance(start, target) < CLUSTER_SEARCH_DIST
+        || range && grid_distance(start, target) > range)
+    {
+        return false;
+    }
+
+    vector<coord_def> path;
+    if (!_cluster_path(_path_field_key(*mons, 0), start, target, path,
+                       expansions))
+    {
+        return false;
+    }
+
+    // The graph may be behind on things that don't change the terrain,
+    // so check every step, and the limits calc_path_to_neighbours() sets.
+    int length = 0;
+    for (unsigned int i = 1; i < path.size(); ++i)
+    {
+        pos = path[i - 1];
+        const coord_def npos = path[i];
+        if (grid_distance(pos, npos) != 1
+            || npos != target && !traversable(npos)
+            || range && estimated_cost(npos) > range)
+        {
+            return false;
+        }
+        length += travel_cost(npos);
+        if (range && length > range * 2)
+            return false;
+    }
+
+    cluster_path = path;
+    return true;
+}
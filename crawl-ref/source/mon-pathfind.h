@@ -12,6 +12,10 @@ using std::vector;
 class monster;
 
 int mons_tracking_range(const monster* mon);
+maybe_bool shared_pathfind(const monster* mon, coord_def dest, int range,
+                           vector<coord_def> &waypoints);
+void cluster_graph_changed(const coord_def &p);
+void cluster_graph_reset();
 
 class monster_pathfind
 {
@@ -21,6 +25,8 @@ public:
 
     // public methods
     void set_range(int r);
+    void set_cluster_search(bool clusters);
+    int nodes_expanded() const;
     coord_def next_pos(const coord_def &p) const;
     bool init_pathfind(const monster* mon, coord_def dest,
                        bool diag = true, bool msg = false,
@@ -33,6 +39,7 @@ public:
 
 protected:
     // protected methods
+    bool cluster_pathfind();
     bool calc_path_to_neighbours();
     bool traversable(const coord_def& p);
     bool traversable_memoized(const coord_def& p);
@@ -69,6 +76,16 @@ protected:
     // Maximum range to search between start and target. None, if zero.
     int range;
 
+    // If true, look for paths to distant targets in the cluster graph
+    // before falling back to a full search.
+    bool cluster_search;
+
+    // The number of positions (or cluster graph nodes) looked at.
+    int expansions;
+
+    // The path found through the cluster graph, if any.
+    vector<coord_def> cluster_path;
+
     // Currently shortest and longest possible total length of the path.
     int min_length;
     int max_length;
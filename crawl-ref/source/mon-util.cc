@@ -4198,6 +4198,20 @@ static bool _mons_can_pass_door(const monster* mon, const coord_def& pos)
                || mons_can_destroy_door(*mon, pos));
 }
 
+/**
+ * Can a monster get past closed doors that have no door_restrict veto?
+ * Only meaningful for monsters not allied with the player: allies can be
+ * kept out of some kinds of door, so use mons_can_traverse() for them.
+ */
+bool mons_can_pass_doors(const monster& mon)
+{
+    return mon.can_pass_through_feat(DNGN_FLOOR)
+           && (_mons_can_open_doors(&mon) && !mon.friendly()
+               || mons_eats_items(mon)
+               || mons_class_flag(mons_base_type(mon), M_EAT_DOORS)
+               || mons_class_flag(mons_base_type(mon), M_CRASH_DOORS));
+}
+
 bool mons_can_traverse(const monster& mon, const coord_def& p,
                        bool only_in_sight, bool checktraps)
 {
@@ -101,6 +101,7 @@ monster::monster()
     clear_constricted();
     went_unseen_this_turn = false;
     unseen_pos = coord_def(0, 0);
+    dormant = false;
 }
 
 // Empty destructor to keep unique_ptr happy with incomplete ghost_demon type.
@@ -150,6 +151,7 @@ void monster::reset()
     god             = GOD_NO_GOD;
     went_unseen_this_turn = false;
     unseen_pos = coord_def(0, 0);
+    dormant = false;
 
     mons_remove_from_grid(*this);
     target.reset();
@@ -268,7 +270,11 @@ bool monster::swimming() const
 
 bool monster::extra_balanced_at(const coord_def p) const
 {
-    const dungeon_feature_type grid = env.grid(p);
+    return extra_balanced_in(env.grid(p));
+}
+
+bool monster::extra_balanced_in(dungeon_feature_type grid) const
+{
     return grid == DNGN_SHALLOW_WATER
            && (mons_genus(type) == MONS_NAGA // tails, not feet
                || mons_genus(type) == MONS_SALAMANDER
@@ -291,17 +297,23 @@ bool monster::extra_balanced() const
  */
 bool monster::floundering_at(const coord_def p) const
 {
-    const dungeon_feature_type grid = env.grid(p);
-    return (liquefied(p)
-            || (feat_is_water(grid)
-                // Can't use monster_habitable_grid() because that'll return
-                // true for non-water monsters in shallow water.
-                && mons_primary_habitat(*this) != HT_WATER
-                // Use real_amphibious to detect giant non-water monsters in
-                // deep water, who flounder despite being treated as amphibious.
-                && mons_habitat(*this, true) != HT_AMPHIBIOUS
-                && !extra_balanced_at(p)))
-           && ground_level();
+    return (liquefied(p) || flounders_in(env.grid(p))) && ground_level();
+}
+
+/**
+ * Would the monster flounder in this terrain if it were on the ground?
+ * Unlike floundering_at(), this ignores flight and liquefaction.
+ */
+bool monster::flounders_in(dungeon_feature_type grid) const
+{
+    return feat_is_water(grid)
+           // Can't use monster_habitable_grid() because that'll return
+           // true for non-water monsters in shallow water.
+           && mons_primary_habitat(*this) != HT_WATER
+           // Use real_amphibious to detect giant non-water monsters in
+           // deep water, who flounder despite being treated as amphibious.
+           && mons_habitat(*this, true) != HT_AMPHIBIOUS
+           && !extra_balanced_in(grid);
 }
 
 bool monster::floundering() const
@@ -4274,6 +4286,8 @@ int monster::hurt(const actor *agent, int amount, beam_type flavour,
                    kill_method_type kill_type, string /*source*/,
                    string /*aux*/, bool cleanup_dead, bool attacker_effects)
 {
+    dormant = false;
+
     if (mons_is_projectile(type)
         || mid == MID_ANON_FRIEND)
     {
@@ -124,6 +124,9 @@ public:
     bool went_unseen_this_turn;
     coord_def unseen_pos;
 
+    bool dormant;                      // Left out of handle_monsters() until
+                                       // something disturbs it. Not saved.
+
 public:
     void set_new_monster_id();
 
@@ -261,8 +264,10 @@ public:
 
     bool     can_drown() const;
     bool     floundering_at(const coord_def p) const;
+    bool     flounders_in(dungeon_feature_type grid) const;
     bool     floundering() const override;
     bool     extra_balanced_at(const coord_def p) const;
+    bool     extra_balanced_in(dungeon_feature_type grid) const;
     bool     extra_balanced() const override;
     bool     can_pass_through_feat(dungeon_feature_type grid) const override;
     bool     can_burrow() const override;
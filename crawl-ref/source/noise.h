@@ -115,7 +115,8 @@ public:
     // Propagate noise from the noise sources registered.
     void propagate_noise();
 
-    // Clear all noise from the noise grid.
+    // Clear all noise from the noise grid. Only the cells the registered
+    // noises could have reached are touched.
     void reset();
 
     bool dirty() const { return !noises.empty(); }
@@ -140,8 +141,22 @@ private:
                                        const coord_def &affected_position,
                                        const noise_t &noise) const;
 
+    bool in_reach(const coord_def &p) const
+    {
+        return p.x >= reach_tl.x && p.x <= reach_br.x
+               && p.y >= reach_tl.y && p.y <= reach_br.y;
+    }
+
 private:
     FixedArray<noise_cell, GXM, GYM> cells;
     vector<noise_t> noises;
     int affected_actor_count;
+
+    // The rectangle holding every cell the registered noises can reach;
+    // empty if reach_tl is right of or below reach_br.
+    coord_def reach_tl, reach_br;
+
+    // The cells the noise has reached on the current and the next step of
+    // propagation. Kept between calls to avoid reallocating them.
+    vector<coord_def> perimeter[2];
 };
@@ -451,6 +451,9 @@ public:
     string game_seed; // string version of the rc option
     uint64_t    seed_from_rc;
     level_gen_type pregen_dungeon;
+    int         pregen_threads; // Worker threads for saving pregen levels.
+    bool        background_save; // Commit checkpoint saves on a thread.
+    int         level_cache_size; // KB of recent levels to keep in memory.
 
 #ifdef DGL_SIMPLE_MESSAGING
     bool        messaging;      // Check for messages.
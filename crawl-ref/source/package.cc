@@ -16,6 +16,19 @@ Notes:
 * Readers always get the last complete (but not necessarily committed) write
   (ie, READ_UNCOMMITTED) at the time they started; it is safe to continue
   reading even if the chunk has been changed since.
+* Each chunk is compressed with zlib or, in builds with USE_LZ4, with LZ4.
+  An LZ4 chunk is a series of frames, each a little-endian header of the
+  decompressed and compressed lengths followed by one LZ4 block, ending
+  with an empty frame. Packages holding only zlib chunks are still written
+  in format 1, which older versions can read.
+* keep_in_memory() holds on to the contents of a chunk that was just written,
+  so that reading it back doesn't need to decompress it. Writing or deleting
+  the chunk again drops them. The contents are shared, not copied, with
+  write_later() and with readers.
+* commit_async() does the same work as commit() on a background thread, on
+  chunks given to write_later(). Until it is done, every other call on the
+  package waits for it, so the on-disk state goes through the same steps and
+  keeps the same guarantees.
 */
 
 #include "AppHdr.h"
@@ -25,6 +38,7 @@ Notes:
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <sstream>
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -32,12 +46,16 @@ Notes:
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
 
 #include "end.h"
 #include "endianness.h"
 #include "errors.h"
 #include "syscalls.h"
 #include "libutil.h" // map_find
+#include "threads.h"
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -59,9 +77,20 @@ static plen_t htole(plen_t x)
 #define dprintf(...) do {} while (0)
 #endif
 
-#define PACKAGE_VERSION 1
+#define ZB_SIZE 32768
+// Decompressed size of a full LZ4 frame.
+#define LZ4_FRAME_SIZE 65536
+
+// Format 2 adds a codec to each directory entry.
+#define PACKAGE_VERSION 2
 #define PACKAGE_MAGIC   0x53534344 /* "DCSS" */
 
+#ifdef USE_LZ4
+#define DEFAULT_CODEC CODEC_LZ4
+#else
+#define DEFAULT_CODEC CODEC_ZLIB
+#endif
+
 struct file_header
 {
     uint32_t magic;
@@ -81,11 +110,19 @@ typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
 typedef map<plen_t, plen_t> fb_t;
 
+struct package_commit
+{
+    thread_t thread;
+    // What the commit failed with, for the main thread to report.
+    string error;
+};
+
 package::package(const char* file, bool writeable, bool empty)
   : n_users(0), dirty(false), aborted(false)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
+    , kept_size(0), committing(nullptr)
 {
     dprintf("package: initializing file=\"%s\" rw=%d\n", file, writeable);
     ASSERT(writeable || !empty);
@@ -136,6 +173,7 @@ package::package()
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
+    , kept_size(0), committing(nullptr)
 {
     dprintf("package: initializing tmp file\n");
     filename = "[tmp]";
@@ -208,6 +246,19 @@ void package::load_traces()
 package::~package()
 {
     dprintf("package: finalizing\n");
+    // A background commit holds chunk writers of its own; let it finish.
+    // Destructors mustn't throw, so if it failed, say so and leave the file
+    // as of the last commit that went through.
+    if (rw && !aborted)
+    {
+        join_commit();
+        if (!commit_error.empty())
+        {
+            fprintf(stderr, "Background save failed: %s\n",
+                    commit_error.c_str());
+            abort();
+        }
+    }
     ASSERT(!n_users || CrawlIsCrashing); // not merely aborted, there are
         // live pointers to us. With normal stack unwinding, destructors
         // will make sure this never happens and this assert is good for
@@ -232,6 +283,93 @@ package::~package()
 }
 
 void package::commit()
+{
+    finish_commit();
+    write_deferred();
+    commit_blocks();
+}
+
+/**
+ * Start committing in the background. The chunks given to write_later() are
+ * compressed and written, then the package is committed as by commit(), on
+ * another thread.
+ *
+ * The caller only waits here if the previous background commit isn't done
+ * yet. Any later call on the package waits for this one to finish, and
+ * fails with the error it met, if any.
+ */
+void package::commit_async()
+{
+    finish_commit();
+    ASSERT(rw);
+    if (!dirty && deferred.empty())
+        return;
+    ASSERT(!aborted);
+
+    committing = new package_commit;
+    if (thread_create_joinable(&committing->thread, _commit_thread, this))
+    {
+        // No thread to be had; do the work here instead.
+        delete committing;
+        committing = nullptr;
+        commit();
+    }
+}
+
+void *package::_commit_thread(void *arg)
+{
+    package *pkg = static_cast<package *>(arg);
+    // Don't take the game down from here, nor unwind past the thread; let
+    // the main thread fail instead.
+    fatal_errors_throw = true;
+    try
+    {
+        pkg->write_deferred();
+        pkg->commit_blocks();
+    }
+    catch (exception &e)
+    {
+        pkg->committing->error = e.what();
+    }
+    catch (...)
+    {
+        pkg->committing->error = "unknown error";
+    }
+    return nullptr;
+}
+
+/**
+ * Wait for a background commit, without throwing. The error it met, if any, is
+ * kept for the next finish_commit() to fail with.
+ */
+void package::join_commit()
+{
+    if (!committing)
+        return;
+
+    thread_join(committing->thread);
+    if (commit_error.empty())
+        commit_error = committing->error;
+    delete committing;
+    committing = nullptr;
+}
+
+/**
+ * Wait for the background commit started by commit_async(), if any, and
+ * fail with the error it met, if any.
+ */
+void package::finish_commit()
+{
+    join_commit();
+    if (commit_error.empty())
+        return;
+
+    const string error = commit_error;
+    commit_error.clear();
+    fail("%s", error.c_str());
+}
+
+void package::commit_blocks()
 {
     ASSERT(rw);
     if (!dirty)
@@ -244,7 +382,7 @@ void package::commit()
 
     file_header head;
     head.magic = htole(PACKAGE_MAGIC);
-    head.version = PACKAGE_VERSION;
+    head.version = codecs.empty() ? 1 : PACKAGE_VERSION;
     memset(&head.padding, 0, sizeof(head.padding));
     head.start = htole(write_directory());
 #ifdef DO_FSYNC
@@ -281,13 +419,138 @@ void package::seek(plen_t to)
 
 chunk_writer* package::writer(const string &name)
 {
+    finish_commit();
+    deferred.erase(name);
+    forget_kept(name);
     return new chunk_writer(this, name);
 }
 
+/**
+ * Save a chunk without compressing or writing it yet. The next commit() or
+ * commit_async() does that; until then, the chunk can be read back as any
+ * other. Takes the contents of data, leaving it empty.
+ *
+ * This is called from the destructor of a deferred writer, so it doesn't
+ * throw: an error from the background commit is left for the next call.
+ */
+void package::write_later(const string &name, vector<unsigned char> &data)
+{
+    write_later(name, make_shared<const vector<unsigned char> >(move(data)));
+    data.clear();
+}
+
+// As above, sharing data rather than taking it; it mustn't change afterwards.
+void package::write_later(const string &name, chunk_data_ptr data)
+{
+    join_commit();
+    ASSERT(rw);
+    ASSERT(!aborted);
+    ASSERT(!name.empty());
+    ASSERT(name.length() < MAX_CHUNK_NAME_LENGTH);
+    ASSERT(data);
+    forget_kept(name);
+    deferred[name] = move(data);
+}
+
+/**
+ * Hold on to a chunk's contents, as just written, for read_kept(). The least
+ * recently kept chunks are dropped to stay within limit bytes. The data is
+ * shared, not copied, so it mustn't change afterwards.
+ */
+void package::keep_in_memory(const string &name, chunk_data_ptr data,
+                             size_t limit)
+{
+    ASSERT(data);
+    forget_kept(name);
+    if (data->size() > limit)
+        return;
+
+    kept_size += data->size();
+    kept.emplace_front(name, move(data));
+    while (kept_size > limit)
+    {
+        kept_size -= kept.back().second->size();
+        kept.pop_back();
+    }
+}
+
+/**
+ * Get the contents of a chunk given to keep_in_memory(), if it is still kept.
+ * They stay valid for as long as the caller holds on to them, even if the
+ * chunk is written again or dropped.
+ *
+ * @return nullptr if the chunk isn't kept, and must be read from the package.
+ */
+chunk_data_ptr package::read_kept(const string &name)
+{
+    finish_commit();
+    for (auto it = kept.begin(); it != kept.end(); ++it)
+    {
+        if (it->first != name)
+            continue;
+        kept.splice(kept.begin(), kept, it);
+        return it->second;
+    }
+    return nullptr;
+}
+
+void package::forget_kept(const string &name)
+{
+    for (auto it = kept.begin(); it != kept.end(); ++it)
+        if (it->first == name)
+        {
+            kept_size -= it->second->size();
+            kept.erase(it);
+            return;
+        }
+}
+
+void package::write_deferred()
+{
+    for (const auto &entry : deferred)
+    {
+        chunk_writer cw(this, entry.first);
+        if (!entry.second->empty())
+            cw.write(entry.second->data(), entry.second->size());
+    }
+    deferred.clear();
+}
+
+void package::write_deferred(const string &name)
+{
+    auto chunk = deferred.find(name);
+    if (chunk == deferred.end())
+        return;
+
+    {
+        chunk_writer cw(this, name);
+        if (!chunk->second->empty())
+            cw.write(chunk->second->data(), chunk->second->size());
+    }
+    deferred.erase(chunk);
+}
+
+/**
+ * Write a chunk whose data was already compressed by compress_chunk_data().
+ *
+ * The data is written out in the same pieces a streaming chunk_writer would
+ * use, so the resulting package is byte-for-byte the same.
+ */
+void package::write_compressed(const string &name,
+                               const vector<unsigned char> &zdata)
+{
+    finish_commit();
+    deferred.erase(name);
+    forget_kept(name);
+    chunk_writer cw(this, name, true);
+    for (size_t i = 0; i < zdata.size(); i += ZB_SIZE)
+        cw.raw_write(&zdata[i], min<size_t>(ZB_SIZE, zdata.size() - i));
+}
+
 chunk_reader* package::reader(const string &name)
 {
-    if (plen_t *ch = map_find(directory, name))
-        return new chunk_reader(this, *ch);
+    if (has_chunk(name))
+        return new chunk_reader(this, name);
     return 0;
 }
 
@@ -359,10 +622,14 @@ plen_t package::alloc_block(plen_t &size)
     return at;
 }
 
-void package::finish_chunk(const string &name, plen_t at)
+void package::finish_chunk(const string &name, plen_t at, chunk_codec codec)
 {
     free_chunk(name);
     directory[name] = at;
+    if (codec == CODEC_ZLIB)
+        codecs.erase(name);
+    else
+        codecs[name] = codec;
     new_chunks.insert(at);
     dirty = true;
 }
@@ -384,13 +651,19 @@ void package::free_chunk(const string &name)
 
 void package::delete_chunk(const string &name)
 {
+    finish_commit();
+    deferred.erase(name);
+    forget_kept(name);
     free_chunk(name);
     directory.erase(name);
+    codecs.erase(name);
 }
 
 plen_t package::write_directory()
 {
-    delete_chunk("");
+    // not delete_chunk(), which would wait for the commit this is part of
+    free_chunk("");
+    directory.erase("");
 
     stringstream dir;
     for (const auto &entry : directory)
@@ -400,6 +673,11 @@ plen_t package::write_directory()
         dir.write(&entry.first[0], entry.first.length());
         plen_t start = htole(entry.second);
         dir.write((const char*)&start, sizeof(plen_t));
+        if (!codecs.empty())
+        {
+            const uint8_t codec = codec_of(entry.first);
+            dir.write((const char*)&codec, sizeof(codec));
+        }
     }
 
     ASSERT(dir.str().size());
@@ -540,6 +818,7 @@ void package::read_directory(plen_t start, uint8_t version)
         }
         break;
     case 1:
+    case 2:
         uint8_t name_len;
         plen_t bstart;
         while (plen_t res = rd.read(&name_len, sizeof(name_len)))
@@ -553,6 +832,19 @@ void package::read_directory(plen_t start, uint8_t version)
             if (rd.read(&bstart, sizeof(bstart)) != sizeof(bstart))
                 corrupted("save file corrupted -- truncated directory");
             directory[chname] = htole(bstart);
+            if (version >= 2)
+            {
+                uint8_t codec;
+                if (rd.read(&codec, sizeof(codec)) != sizeof(codec))
+                    corrupted("save file corrupted -- truncated directory");
+                if (codec >= NUM_CODECS)
+                {
+                    corrupted("save file (%s) uses an unknown codec %u",
+                              filename.c_str(), codec);
+                }
+                if (codec != CODEC_ZLIB)
+                    codecs[chname] = (chunk_codec)codec;
+            }
             dprintf("* %s\n", chname.c_str());
         }
         break;
@@ -564,16 +856,20 @@ void package::read_directory(plen_t start, uint8_t version)
 
 bool package::has_chunk(const string &name)
 {
-    return !name.empty() && directory.count(name);
+    finish_commit();
+    return !name.empty() && (directory.count(name) || deferred.count(name));
 }
 
 vector<string> package::list_chunks()
 {
+    finish_commit();
     vector<string> list;
-    list.reserve(directory.size());
+    list.reserve(directory.size() + deferred.size());
     for (const auto &entry : directory)
-        if (!entry.first.empty())
+        if (!entry.first.empty() && !deferred.count(entry.first))
             list.push_back(entry.first);
+    for (const auto &entry : deferred)
+        list.push_back(entry.first);
 
     return list;
 }
@@ -619,6 +915,11 @@ void package::abort()
     // Disable any further operations, allow a shutdown. All errors past
     // this point are ignored (assuming we already failed). All writes since
     // the last commit() are lost.
+    join_commit();
+    commit_error.clear();
+    deferred.clear();
+    kept.clear();
+    kept_size = 0;
     aborted = true;
 }
 
@@ -633,6 +934,7 @@ void package::unlink()
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
+    finish_commit();
     load_traces();
 
     plen_t slack = 0;
@@ -643,6 +945,7 @@ plen_t package::get_slack()
 
 plen_t package::get_chunk_fragmentation(const string &name)
 {
+    finish_commit();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t frags = 0;
@@ -657,8 +960,22 @@ plen_t package::get_chunk_fragmentation(const string &name)
     return frags;
 }
 
+chunk_codec package::get_chunk_codec(const string &name)
+{
+    finish_commit();
+    return codec_of(name);
+}
+
+// As above, without waiting for a background commit; for the commit itself.
+chunk_codec package::codec_of(const string &name) const
+{
+    const auto codec = codecs.find(name);
+    return codec == codecs.end() ? CODEC_ZLIB : codec->second;
+}
+
 plen_t package::get_chunk_compressed_length(const string &name)
 {
+    finish_commit();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t len = 0;
@@ -673,8 +990,13 @@ plen_t package::get_chunk_compressed_length(const string &name)
     return len;
 }
 
-chunk_writer::chunk_writer(package *parent, const string &_name)
-    : first_block(0), cur_block(0), block_len(0)
+chunk_writer::chunk_writer(package *parent, const string &_name,
+                           bool _precompressed)
+    : first_block(0), cur_block(0), block_len(0),
+      precompressed(_precompressed),
+      // The directory itself is always zlib, so that its format can be read
+      // before knowing any codecs.
+      codec(_precompressed || _name.empty() ? CODEC_ZLIB : DEFAULT_CODEC)
 {
     ASSERT(parent);
     ASSERT(!parent->aborted);
@@ -688,14 +1010,23 @@ chunk_writer::chunk_writer(package *parent, const string &_name)
     pkg->n_users++;
     name = _name;
 
+#ifdef USE_LZ4
+    if (codec == CODEC_LZ4)
+    {
+        lz_in.reserve(LZ4_FRAME_SIZE);
+        lz_out.resize(2 * sizeof(plen_t) + LZ4_compressBound(LZ4_FRAME_SIZE));
+        return;
+    }
+#endif
 #ifdef USE_ZLIB
+    if (precompressed)
+        return;
     zs.data_type = Z_BINARY;
     zs.zalloc    = 0;
     zs.zfree     = 0;
     zs.opaque    = Z_NULL;
     if (deflateInit(&zs, Z_DEFAULT_COMPRESSION))
         fail("save file compression failed during init: %s", zs.msg);
-#define ZB_SIZE 32768
     zs.next_out  = z_buffer = (Bytef*)malloc(ZB_SIZE);
     zs.avail_out = ZB_SIZE;
 #endif
@@ -710,32 +1041,47 @@ chunk_writer::~chunk_writer()
     if (pkg->aborted)
     {
 #ifdef USE_ZLIB
-        // ignore errors, they're not relevant anymore
-        deflateEnd(&zs);
-        free(z_buffer);
+        if (!precompressed && codec == CODEC_ZLIB)
+        {
+            // ignore errors, they're not relevant anymore
+            deflateEnd(&zs);
+            free(z_buffer);
+        }
 #endif
         return;
     }
 
+#ifdef USE_LZ4
+    if (codec == CODEC_LZ4)
+    {
+        if (!lz_in.empty())
+            lz4_write_frame();
+        // An empty frame marks the end of the chunk.
+        lz4_write_frame();
+    }
+#endif
 #ifdef USE_ZLIB
-    zs.avail_in = 0;
-    int res;
-    do
+    if (!precompressed && codec == CODEC_ZLIB)
     {
-        res = deflate(&zs, Z_FINISH);
-        if (res != Z_STREAM_END && res != Z_OK && res != Z_BUF_ERROR)
-            fail("save file compression failed: %s", zs.msg);
-        raw_write(z_buffer, zs.next_out - z_buffer);
-        zs.next_out = z_buffer;
-        zs.avail_out = ZB_SIZE;
-    } while (res != Z_STREAM_END);
-    if (deflateEnd(&zs) != Z_OK)
-        fail("save file compression failed during clean-up: %s", zs.msg);
-    free(z_buffer);
+        zs.avail_in = 0;
+        int res;
+        do
+        {
+            res = deflate(&zs, Z_FINISH);
+            if (res != Z_STREAM_END && res != Z_OK && res != Z_BUF_ERROR)
+                fail("save file compression failed: %s", zs.msg);
+            raw_write(z_buffer, zs.next_out - z_buffer);
+            zs.next_out = z_buffer;
+            zs.avail_out = ZB_SIZE;
+        } while (res != Z_STREAM_END);
+        if (deflateEnd(&zs) != Z_OK)
+            fail("save file compression failed during clean-up: %s", zs.msg);
+        free(z_buffer);
+    }
 #endif
     if (cur_block)
         finish_block(0);
-    pkg->finish_chunk(name, first_block);
+    pkg->finish_chunk(name, first_block, codec);
 }
 
 void chunk_writer::raw_write(const void *data, plen_t len)
@@ -777,11 +1123,46 @@ void chunk_writer::finish_block(plen_t next)
     pkg->block_map[cur_block] = bm_p(block_len, next);
 }
 
+#ifdef USE_LZ4
+// Compress and write out the buffered data as one frame.
+void chunk_writer::lz4_write_frame()
+{
+    const int zlen = lz_in.empty() ? 0
+        : LZ4_compress_default(lz_in.data(), &lz_out[2 * sizeof(plen_t)],
+                               lz_in.size(),
+                               lz_out.size() - 2 * sizeof(plen_t));
+    if (zlen <= 0 && !lz_in.empty())
+        fail("save file compression failed");
+
+    const plen_t head[2] = { htole((plen_t)lz_in.size()), htole((plen_t)zlen) };
+    memcpy(&lz_out[0], head, sizeof(head));
+    raw_write(&lz_out[0], sizeof(head) + zlen);
+    lz_in.clear();
+}
+#endif
+
 void chunk_writer::write(const void *data, plen_t len)
 {
     ASSERT(data);
     ASSERT(!pkg->aborted);
+    ASSERT(!precompressed);
 
+#ifdef USE_LZ4
+    if (codec == CODEC_LZ4)
+    {
+        const char *in = (const char *)data;
+        while (len)
+        {
+            const plen_t s = min<plen_t>(len, LZ4_FRAME_SIZE - lz_in.size());
+            lz_in.insert(lz_in.end(), in, in + s);
+            in += s;
+            len -= s;
+            if (lz_in.size() == LZ4_FRAME_SIZE)
+                lz4_write_frame();
+        }
+        return;
+    }
+#endif
 #ifdef USE_ZLIB
     zs.next_in  = (Bytef*)data;
     zs.avail_in = len;
@@ -802,14 +1183,60 @@ void chunk_writer::write(const void *data, plen_t len)
 #endif
 }
 
-void chunk_reader::init(plen_t start)
+/**
+ * Compress a whole chunk ahead of time, producing the same stream as writing
+ * it through a chunk_writer. This touches no package state, so it is safe to
+ * call from a worker thread.
+ *
+ * @return false if zlib failed.
+ */
+bool compress_chunk_data(const vector<unsigned char> &data,
+                         vector<unsigned char> &zdata)
+{
+#ifdef USE_ZLIB
+    z_stream zs;
+    zs.data_type = Z_BINARY;
+    zs.zalloc    = 0;
+    zs.zfree     = 0;
+    zs.opaque    = Z_NULL;
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION))
+        return false;
+
+    zdata.resize(deflateBound(&zs, data.size()));
+    zs.next_in   = const_cast<Bytef*>(data.data());
+    zs.avail_in  = data.size();
+    zs.next_out  = zdata.data();
+    zs.avail_out = zdata.size();
+    const int res = deflate(&zs, Z_FINISH);
+    zdata.resize(zs.total_out);
+    return deflateEnd(&zs) == Z_OK && res == Z_STREAM_END;
+#else
+    zdata = data;
+    return true;
+#endif
+}
+
+void chunk_reader::init(plen_t start, chunk_codec _codec)
 {
     ASSERT(!pkg->aborted);
+#ifndef USE_LZ4
+    // Before counting this reader as a user: nothing would undo that if the
+    // check threw.
+    if (_codec == CODEC_LZ4)
+    {
+        corrupted("save file (%s) uses LZ4 compression, which this build "
+                  "does not support", pkg->filename.c_str());
+    }
+#endif
     pkg->n_users++;
     pkg->reader_count[start]++;
     first_block = next_block = start;
     block_left = 0;
+    codec = _codec;
 
+#ifdef USE_LZ4
+    lz_pos = 0;
+#endif
 #ifdef USE_ZLIB
     if (!start)
         corrupted("save file corrupted -- zlib header missing");
@@ -830,7 +1257,7 @@ chunk_reader::chunk_reader(package *parent, plen_t start)
     ASSERT(parent);
     dprintf("chunk_reader[%u]: starting\n", start);
     pkg = parent;
-    init(start);
+    init(start, CODEC_ZLIB);
 }
 
 chunk_reader::chunk_reader(package *parent, const string &_name)
@@ -838,9 +1265,11 @@ chunk_reader::chunk_reader(package *parent, const string &_name)
     ASSERT(parent);
     if (!parent->has_chunk(_name))
         corrupted("save file corrupted -- chunk \"%s\" missing", _name.c_str());
+    // Readers see deferred chunks like any other write.
+    parent->write_deferred(_name);
     dprintf("chunk_reader(%s): starting\n", _name.c_str());
     pkg = parent;
-    init(parent->directory[_name]);
+    init(parent->directory[_name], parent->get_chunk_codec(_name));
 }
 
 chunk_reader::~chunk_reader()
@@ -904,12 +1333,92 @@ plen_t chunk_reader::raw_read(void *data, plen_t len)
     return (char*)buf - (char*)data;
 }
 
+#ifdef USE_LZ4
+/**
+ * Read the header of the next LZ4 frame.
+ *
+ * @return The decompressed length of the frame, 0 at the end of the chunk.
+ */
+plen_t chunk_reader::lz4_next_frame()
+{
+    if (eof)
+        return 0;
+
+    plen_t head[2];
+    if (raw_read(head, sizeof(head)) != sizeof(head))
+        corrupted("save file corrupted -- block truncated");
+    const plen_t raw_len = htole(head[0]);
+    const plen_t zlen = htole(head[1]);
+    if (raw_len > LZ4_FRAME_SIZE || !raw_len != !zlen
+        || (int)zlen > LZ4_compressBound(LZ4_FRAME_SIZE))
+    {
+        corrupted("save file corrupted -- bad LZ4 frame");
+    }
+    if (!raw_len)
+    {
+        eof = true;
+        return 0;
+    }
+
+    lz_in.resize(zlen);
+    if (raw_read(&lz_in[0], zlen) != zlen)
+        corrupted("save file corrupted -- block truncated");
+    return raw_len;
+}
+
+// Decompress the frame whose header lz4_next_frame() just read.
+void chunk_reader::lz4_decode_frame(char *dest, plen_t raw_len)
+{
+    if (LZ4_decompress_safe(lz_in.data(), dest, lz_in.size(), raw_len)
+        != (int)raw_len)
+    {
+        corrupted("save file decompression failed");
+    }
+}
+
+plen_t chunk_reader::lz4_read(void *data, plen_t len)
+{
+    char *out = (char *)data;
+    while (len)
+    {
+        if (lz_pos == lz_frame.size())
+        {
+            const plen_t raw_len = lz4_next_frame();
+            if (!raw_len)
+                break;
+            // Whole frames go straight to the caller.
+            if (raw_len <= len)
+            {
+                lz4_decode_frame(out, raw_len);
+                out += raw_len;
+                len -= raw_len;
+                continue;
+            }
+            lz_frame.resize(raw_len);
+            lz_pos = 0;
+            lz4_decode_frame(&lz_frame[0], raw_len);
+        }
+
+        const plen_t s = min<plen_t>(len, lz_frame.size() - lz_pos);
+        memcpy(out, &lz_frame[lz_pos], s);
+        lz_pos += s;
+        out += s;
+        len -= s;
+    }
+    return out - (char *)data;
+}
+#endif
+
 plen_t chunk_reader::read(void *data, plen_t len)
 {
     ASSERT(data);
     if (pkg->aborted)
         return 0;
 
+#ifdef USE_LZ4
+    if (codec == CODEC_LZ4)
+        return lz4_read(data, len);
+#endif
 #ifdef USE_ZLIB
     if (!len)
         return 0;
@@ -942,16 +1451,32 @@ plen_t chunk_reader::read(void *data, plen_t len)
 #endif
 }
 
-void chunk_reader::read_all(vector<char> &data)
+/**
+ * Append the rest of the chunk to data. The buffer grows geometrically and
+ * the codec writes straight into it, so a whole chunk is decompressed with
+ * only a few large reads.
+ */
+template<typename T>
+void chunk_reader::read_all_into(vector<T> &data)
 {
-#define SPACE 1024
-    plen_t s, at;
+    static_assert(sizeof(T) == 1, "chunk data is read as bytes");
+    plen_t s, at, space;
     do
     {
         at = data.size();
-        data.resize(at + SPACE);
-        s = read(&data[at], SPACE);
-    } while (s == SPACE);
+        space = max<plen_t>(at, 16384);
+        data.resize(at + space);
+        s = read(&data[at], space);
+    } while (s == space);
     data.resize(at + s);
-#undef SPACE
+}
+
+void chunk_reader::read_all(vector<char> &data)
+{
+    read_all_into(data);
+}
+
+void chunk_reader::read_all(vector<unsigned char> &data)
+{
+    read_all_into(data);
 }
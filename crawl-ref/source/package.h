@@ -2,7 +2,9 @@
 
 #define USE_ZLIB
 
+#include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -10,9 +12,11 @@
 #include <zlib.h>
 #endif
 
+using std::list;
 using std::map;
 using std::pair;
 using std::set;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -24,7 +28,21 @@ using std::vector;
 
 typedef uint32_t plen_t;
 
+// How the data of a chunk is compressed. The directory stores these values,
+// so don't renumber them.
+enum chunk_codec : uint8_t
+{
+    CODEC_ZLIB,
+    CODEC_LZ4,  // needs USE_LZ4
+    NUM_CODECS,
+};
+
 class package;
+struct package_commit;
+
+// The uncompressed contents of a chunk, shared between the package and its
+// readers so that handing them around doesn't copy them.
+typedef shared_ptr<const vector<unsigned char> > chunk_data_ptr;
 
 class chunk_writer
 {
@@ -34,14 +52,22 @@ private:
     plen_t first_block;
     plen_t cur_block;
     plen_t block_len;
+    bool precompressed;
+    chunk_codec codec;
 #ifdef USE_ZLIB
     z_stream zs;
     Bytef *z_buffer;
+#endif
+#ifdef USE_LZ4
+    vector<char> lz_in;
+    vector<char> lz_out;
+    void lz4_write_frame();
 #endif
     void raw_write(const void *data, plen_t len);
     void finish_block(plen_t next);
 public:
-    chunk_writer(package *parent, const string &_name);
+    chunk_writer(package *parent, const string &_name,
+                 bool _precompressed = false);
     ~chunk_writer();
     void write(const void *data, plen_t len);
     friend class package;
@@ -51,21 +77,33 @@ class chunk_reader
 {
 private:
     chunk_reader(package *parent, plen_t start);
-    void init(plen_t start);
+    void init(plen_t start, chunk_codec _codec);
     package *pkg;
     plen_t first_block, next_block;
     plen_t off, block_left;
+    chunk_codec codec;
 #ifdef USE_ZLIB
     bool eof;
     z_stream zs;
     Bytef z_buffer[32768];
+#endif
+#ifdef USE_LZ4
+    // The decompressed frame being read, for reads that end inside a frame.
+    vector<char> lz_frame;
+    plen_t lz_pos;
+    vector<char> lz_in;
+    plen_t lz4_read(void *data, plen_t len);
+    plen_t lz4_next_frame();
+    void lz4_decode_frame(char *dest, plen_t raw_len);
 #endif
     plen_t raw_read(void *data, plen_t len);
+    template<typename T> void read_all_into(vector<T> &data);
 public:
     chunk_reader(package *parent, const string &_name);
     ~chunk_reader();
     plen_t read(void *data, plen_t len);
     void read_all(vector<char> &data);
+    void read_all(vector<unsigned char> &data);
     friend class package;
 };
 
@@ -76,8 +114,17 @@ public:
     package();
     ~package();
     chunk_writer* writer(const string &name);
+    void write_compressed(const string &name,
+                          const vector<unsigned char> &zdata);
     chunk_reader* reader(const string &name);
+    void write_later(const string &name, vector<unsigned char> &data);
+    void write_later(const string &name, chunk_data_ptr data);
+    void keep_in_memory(const string &name, chunk_data_ptr data,
+                        size_t limit);
+    chunk_data_ptr read_kept(const string &name);
     void commit();
+    void commit_async();
+    void finish_commit();
     void delete_chunk(const string &name);
     bool has_chunk(const string &name);
     vector<string> list_chunks();
@@ -90,6 +137,7 @@ public:
     plen_t get_size() const { return file_len; };
     plen_t get_chunk_fragmentation(const string &name);
     plen_t get_chunk_compressed_length(const string &name);
+    chunk_codec get_chunk_codec(const string &name);
 private:
     string filename;
     bool rw;
@@ -102,16 +150,34 @@ private:
     bool tmp;
 #endif
     map<string, plen_t> directory;
+    // Codecs of the chunks that aren't zlib.
+    map<string, chunk_codec> codecs;
     map<plen_t, plen_t> free_blocks;
     vector<plen_t> unlinked_blocks;
     map<plen_t, pair<plen_t, plen_t> > block_map;
     set<plen_t> new_chunks;
     map<plen_t, uint32_t> reader_count;
+    // Chunks given to write_later(), not yet compressed or written.
+    map<string, chunk_data_ptr> deferred;
+    // Uncompressed contents of recently written chunks, most recent first.
+    list<pair<string, chunk_data_ptr> > kept;
+    size_t kept_size;
+    void forget_kept(const string &name);
+    // The commit running in the background, if any.
+    package_commit *committing;
+    // What a background commit failed with, not yet reported.
+    string commit_error;
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
-    void finish_chunk(const string &name, plen_t at);
+    void finish_chunk(const string &name, plen_t at, chunk_codec codec);
+    void write_deferred();
+    void write_deferred(const string &name);
+    void commit_blocks();
+    void join_commit();
+    static void *_commit_thread(void *arg);
     void free_chunk(const string &name);
     plen_t write_directory();
+    chunk_codec codec_of(const string &name) const;
     void collect_blocks();
     void free_block_chain(plen_t at);
     void free_block(plen_t at, plen_t size);
@@ -124,3 +190,6 @@ private:
     friend class chunk_writer;
     friend class chunk_reader;
 };
+
+bool compress_chunk_data(const vector<unsigned char> &data,
+                         vector<unsigned char> &zdata);
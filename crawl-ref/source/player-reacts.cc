@@ -813,7 +813,7 @@ static void _decrement_durations()
     if (you.duration[DUR_FLAYED])
     {
         bool near_ghost = false;
-        for (monster_iterator mi; mi; ++mi)
+        for (monster_radius_iterator mi(you.pos(), LOS_RADIUS); mi; ++mi)
         {
             if (mi->type == MONS_FLAYED_GHOST && !mi->wont_attack()
                 && you.see_cell(mi->pos()))
@@ -35,10 +35,13 @@
 #include "state.h"
 #include "stringutil.h"
 #include "terrain.h"
+#include "unwind.h"
 #include "view.h"
 #include "viewchar.h"
 
-static noise_grid _noise_grid;
+// Noises are registered on one grid while the other is propagating.
+static noise_grid _noise_grids[2];
+static noise_grid *_noise_grid = &_noise_grids[0];
 static void _actor_apply_noise(actor *act,
                                const coord_def &apparent_source,
                                int noise_intensity_millis);
@@ -803,17 +806,30 @@ void yell(const actor* mon)
 
 void apply_noises()
 {
+    static bool propagating = false;
+
+    if (!_noise_grid->dirty())
+        return;
+
     // [ds] This copying isn't awesome, but we cannot otherwise handle
-    // the case where one set of noises wakes up monsters who then let
-    // out yips of their own, modifying _noise_grid while it is in the
-    // middle of propagate_noise().
-    if (_noise_grid.dirty())
+    // noises applied while we're already propagating some.
+    if (propagating)
     {
-        noise_grid copy = _noise_grid;
+        noise_grid copy = *_noise_grid;
         // Reset the main grid.
-        _noise_grid.reset();
+        _noise_grid->reset();
         copy.propagate_noise();
+        return;
     }
+
+    // One set of noises may wake up monsters who then let out yips of
+    // their own; those go to the other grid, and are propagated next time.
+    noise_grid &grid = *_noise_grid;
+    _noise_grid = &_noise_grids[_noise_grid == &_noise_grids[0]];
+
+    unwind_bool busy(propagating, true);
+    grid.propagate_noise();
+    grid.reset();
 }
 
 // noisy() has a messaging service for giving messages to the player
@@ -864,7 +880,7 @@ bool noisy(int original_loudness, const coord_def& where,
     // Add +1 to scaled_loudness so that all squares adjacent to a
     // sound of loudness 1 will hear the sound.
     const string noise_msg(msg ? msg : "");
-    _noise_grid.register_noise(
+    _noise_grid->register_noise(
         noise_t(where, noise_msg, (scaled_loudness + 1) * multiplier, who,
                 fake_noise));
 
@@ -962,13 +978,19 @@ int noise_cell::turn_angle(const coord_def &next_delta) const
 }
 
 noise_grid::noise_grid()
-    : cells(), noises(), affected_actor_count(0)
+    : cells(), noises(), affected_actor_count(0),
+      reach_tl(GXM, GYM), reach_br(-1, -1), perimeter()
 {
 }
 
 void noise_grid::reset()
 {
-    cells.init(noise_cell());
+    for (int x = reach_tl.x; x <= reach_br.x; ++x)
+        for (int y = reach_tl.y; y <= reach_br.y; ++y)
+            cells[x][y] = noise_cell();
+
+    reach_tl = coord_def(GXM, GYM);
+    reach_br = coord_def(-1, -1);
     noises.clear();
     affected_actor_count = 0;
 }
@@ -978,6 +1000,20 @@ void noise_grid::register_noise(const noise_t &noise)
     noise_cell &target_cell(cells(noise.noise_source));
     if (target_cell.can_apply_noise(noise.noise_intensity_millis))
     {
+        // Every step attenuates the noise by at least the base attenuation,
+        // so this is as far as it can stay audible.
+        const int reach = max(0, noise.noise_intensity_millis
+                                 - LOWEST_AUDIBLE_NOISE_INTENSITY_MILLIS)
+                          / BASE_NOISE_ATTENUATION_MILLIS;
+        const coord_def tl = clamp_in_bounds(noise.noise_source
+                                             - coord_def(reach, reach));
+        const coord_def br = clamp_in_bounds(noise.noise_source
+                                             + coord_def(reach, reach));
+        reach_tl.x = min(reach_tl.x, tl.x);
+        reach_tl.y = min(reach_tl.y, tl.y);
+        reach_br.x = max(reach_br.x, br.x);
+        reach_br.y = max(reach_br.y, br.y);
+
         const int noise_index = noises.size();
         noises.push_back(noise);
         noises[noise_index].noise_id = noise_index;
@@ -997,19 +1033,20 @@ void noise_grid::propagate_noise()
     dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
          (unsigned int)noises.size());
 #endif
-    vector<coord_def> noise_perimeter[2];
     int circ_index = 0;
+    perimeter[0].clear();
+    perimeter[1].clear();
 
     for (const noise_t &noise : noises)
-        noise_perimeter[circ_index].push_back(noise.noise_source);
+        perimeter[circ_index].push_back(noise.noise_source);
 
     int travel_distance = 0;
-    while (!noise_perimeter[circ_index].empty())
+    while (!perimeter[circ_index].empty())
     {
-        const vector<coord_def> &perimeter(noise_perimeter[circ_index]);
-        vector<coord_def> &next_perimeter(noise_perimeter[!circ_index]);
+        const vector<coord_def> &current(perimeter[circ_index]);
+        vector<coord_def> &next_perimeter(perimeter[!circ_index]);
         ++travel_distance;
-        for (const coord_def &p : perimeter)
+        for (const coord_def &p : current)
         {
             const noise_cell &cell(cells(p));
 
@@ -1051,7 +1088,7 @@ void noise_grid::propagate_noise()
             }
         }
 
-        noise_perimeter[circ_index].clear();
+        perimeter[circ_index].clear();
         circ_index = !circ_index;
     }
 
@@ -1092,9 +1129,13 @@ bool noise_grid::propagate_noise_to_neighbour(int base_attenuation,
                                   cell.noise_id,
                                   travel_distance,
                                   next_pos - current_pos))
+        {
+            // reset() only clears the cells noise could reach.
+            ASSERT(in_reach(next_pos));
             // Return true only if we hadn't already registered this
             // cell as a neighbour (presumably with a lower volume).
             return neighbour_old_distance != travel_distance;
+        }
     }
     return false;
 }
@@ -1234,6 +1275,8 @@ coord_def noise_grid::noise_perceived_position(actor *act,
 
 #include <cmath>
 
+#include "syscalls.h"
+
 // Return HTML RGB triple given a hue and assuming chroma of 0.86 (220)
 static string _hue_rgb(int hue)
 {
@@ -1339,14 +1382,11 @@ static void _actor_apply_noise(actor *act,
 {
 #ifdef DEBUG_NOISE_PROPAGATION
     dprf(DIAG_NOISE, "[NOISE] Actor %s (%d,%d) perceives noise (%d) "
-         "from (%d,%d), real source (%d,%d), distance: %d, noise travelled: %d",
+         "from (%d,%d)",
          act->name(DESC_PLAIN, true).c_str(),
          act->pos().x, act->pos().y,
          noise_intensity_millis,
-         apparent_source.x, apparent_source.y,
-         noise.noise_source.x, noise.noise_source.y,
-         grid_distance(act->pos(), noise.noise_source),
-         noise_travel_distance);
+         apparent_source.x, apparent_source.y);
 #endif
 
     const bool player = act->is_player();
@@ -176,6 +176,12 @@ static void _initialize()
     }
 #endif
 
+    if (!crawl_state.save_stats.empty())
+    {
+        release_cli_signals();
+        print_save_stats(crawl_state.save_stats); // noreturn
+    }
+
     if (!crawl_state.test_list)
     {
         if (!crawl_state.io_inited)
@@ -70,8 +70,10 @@ struct game_state
     bool map_stat_dump_disconnect; // Set if we dump disconnected maps and exit
                                    // under mapstat.
     bool obj_stat_gen;      // Set if we're generating object stats.
+    bool map_stat_bench;    // Set if mapstat should time level builds.
 
     string force_map;       // Set if we're forcing a specific map to generate.
+    string save_stats;      // Set if we're reporting on this save and exiting.
 
     game_type type;
     game_type last_type;
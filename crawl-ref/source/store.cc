@@ -1203,6 +1203,119 @@ string &CrawlStoreValue::operator += (const string &_val)
     return get_string() += _val;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Property key interning
+//
+// An open-addressed table of ids, hashed by key, over the list of key
+// names. Keys are never removed.
+
+struct prop_key_table
+{
+    vector<string> names;
+    vector<prop_key_id> slots; // size is a power of two
+};
+
+static prop_key_table &_prop_keys()
+{
+    static prop_key_table table;
+    return table;
+}
+
+static uint32_t _hash_prop_key(const char *key, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (uint8_t) key[i]) * 16777619u;
+    return hash;
+}
+
+// The slot holding this key, or the empty slot where it would go.
+static size_t _prop_key_slot(const prop_key_table &table, const char *key,
+                             size_t len)
+{
+    const size_t mask = table.slots.size() - 1;
+    for (size_t i = _hash_prop_key(key, len) & mask;; i = (i + 1) & mask)
+    {
+        const prop_key_id id = table.slots[i];
+        if (id == NO_PROP_KEY)
+            return i;
+        const string &name = table.names[id];
+        if (name.size() == len && !memcmp(name.data(), key, len))
+            return i;
+    }
+}
+
+prop_key_id find_prop_key(const char *key, size_t len)
+{
+    const prop_key_table &table = _prop_keys();
+    if (table.slots.empty())
+        return NO_PROP_KEY;
+    return table.slots[_prop_key_slot(table, key, len)];
+}
+
+prop_key_id intern_prop_key(const char *key, size_t len)
+{
+    prop_key_table &table = _prop_keys();
+    if (table.slots.empty())
+        table.slots.assign(1024, NO_PROP_KEY);
+
+    const size_t slot = _prop_key_slot(table, key, len);
+    if (table.slots[slot] != NO_PROP_KEY)
+        return table.slots[slot];
+
+    const prop_key_id id = table.names.size();
+    table.names.emplace_back(key, len);
+    table.slots[slot] = id;
+
+    // Keep the table at most half full.
+    if (table.names.size() * 2 > table.slots.size())
+    {
+        table.slots.assign(table.slots.size() * 2, NO_PROP_KEY);
+        for (prop_key_id i = 0; i < table.names.size(); i++)
+        {
+            const string &name = table.names[i];
+            table.slots[_prop_key_slot(table, name.data(), name.size())] = i;
+        }
+    }
+    return id;
+}
+
+const string &prop_key_name(prop_key_id id)
+{
+    const prop_key_table &table = _prop_keys();
+    ASSERT(id < table.names.size());
+    return table.names[id];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CrawlHashTable::CrawlHashTable()
+{
+}
+
+CrawlHashTable::CrawlHashTable(const CrawlHashTable &other)
+{
+    *this = other;
+}
+
+CrawlHashTable::~CrawlHashTable()
+{
+}
+
+CrawlHashTable &CrawlHashTable::operator = (const CrawlHashTable &other)
+{
+    if (this == &other)
+        return *this;
+
+    ids = other.ids;
+    entries.clear();
+    entries.reserve(other.entries.size());
+    for (const auto &entry : other.entries)
+        entries.emplace_back(new value_type(*entry));
+    return *this;
+}
+
 //////////////////////////////
 // Read/write from/to savefile
 void CrawlHashTable::write(writer &th) const
@@ -1262,13 +1375,6 @@ static map<string, int> accesses;
 //////////////////
 // Misc functions
 
-bool CrawlHashTable::exists(const string &key) const
-{
-    ACCESS(key);
-    ASSERT_VALIDITY();
-    return find(key) != end();
-}
-
 void CrawlHashTable::assert_validity() const
 {
 #ifdef DEBUG
@@ -1333,28 +1439,86 @@ void CrawlHashTable::assert_validity() const
 ////////////////////////////////
 // Accessors to contained values
 
-CrawlStoreValue& CrawlHashTable::get_value(const string &key)
+int CrawlHashTable::_find(const char *key, size_t len) const
 {
     ASSERT_VALIDITY();
-    ACCESS(key);
-    // Inserts CrawlStoreValue() if the key was not found.
-    return map::operator[](key);
+    ACCESS(string(key, len));
+    const prop_key_id id = find_prop_key(key, len);
+    if (id == NO_PROP_KEY)
+        return -1;
+
+    auto it = std::find(ids.begin(), ids.end(), id);
+    return it == ids.end() ? -1 : it - ids.begin();
 }
 
-const CrawlStoreValue& CrawlHashTable::get_value(const string &key) const
+CrawlStoreValue& CrawlHashTable::_get_value(const char *key, size_t len)
 {
-    ASSERT_VALIDITY();
-    ACCESS(key);
-    auto iter = find(key);
-    ASSERTM(iter != end(), "trying to read non-existent property \"%s\"", key.c_str());
+    const int i = _find(key, len);
+    if (i >= 0)
+        return entries[i]->second;
 
-    const CrawlStoreValue& store = iter->second;
+    // Insert an unset CrawlStoreValue, keeping the entries in key order.
+    auto pos = lower_bound(entries.begin(), entries.end(), make_pair(key, len),
+        [](const unique_ptr<value_type> &entry, pair<const char*, size_t> k)
+        {
+            return entry->first.compare(0, string::npos, k.first, k.second)
+                   < 0;
+        });
+    const int j = pos - entries.begin();
+    ids.insert(ids.begin() + j, intern_prop_key(key, len));
+    entries.emplace(pos, new value_type(string(key, len), CrawlStoreValue()));
+    return entries[j]->second;
+}
+
+const CrawlStoreValue& CrawlHashTable::_get_value(const char *key,
+                                                  size_t len) const
+{
+    const int i = _find(key, len);
+    ASSERTM(i >= 0, "trying to read non-existent property \"%s\"",
+            string(key, len).c_str());
+
+    const CrawlStoreValue& store = entries[i]->second;
     ASSERT(store.type != SV_NONE);
     ASSERT(!(store.flags & SFLAG_UNSET));
 
     return store;
 }
 
+CrawlHashTable::iterator CrawlHashTable::find(const string &key)
+{
+    const int i = _find(key.data(), key.size());
+    return i < 0 ? end() : iterator(entries.begin() + i);
+}
+
+CrawlHashTable::const_iterator CrawlHashTable::find(const string &key) const
+{
+    const int i = _find(key.data(), key.size());
+    return i < 0 ? end() : const_iterator(entries.begin() + i);
+}
+
+CrawlHashTable::iterator CrawlHashTable::erase(const_iterator pos)
+{
+    const int i = pos.it - entries.begin();
+    ids.erase(ids.begin() + i);
+    entries.erase(entries.begin() + i);
+    return iterator(entries.begin() + i);
+}
+
+CrawlHashTable::size_type CrawlHashTable::_erase(const char *key, size_t len)
+{
+    const int i = _find(key, len);
+    if (i < 0)
+        return 0;
+    erase(const_iterator(entries.begin() + i));
+    return 1;
+}
+
+void CrawlHashTable::clear()
+{
+    ids.clear();
+    entries.clear();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
@@ -7,7 +7,10 @@
 #pragma once
 
 #include <climits>
+#include <cstring>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -241,27 +244,112 @@ protected:
     friend class CrawlVector;
 };
 
-class CrawlHashTable : public map<string, CrawlStoreValue>
+// Property keys are interned: the first time a key is stored anywhere it
+// gets a small integer id, and tables look keys up by id instead of walking
+// a tree of string comparisons. Ids last for the process only and are never
+// saved.
+typedef uint32_t prop_key_id;
+#define NO_PROP_KEY UINT32_MAX
+
+prop_key_id intern_prop_key(const char *key, size_t len);
+// The id of a key that has already been interned, or NO_PROP_KEY. A key no
+// table has ever held can't be in any of them.
+prop_key_id find_prop_key(const char *key, size_t len);
+const string &prop_key_name(prop_key_id id);
+
+// A string-keyed table with the interface of the std::map it used to be.
+// Entries live on the heap and are kept in key order, so iteration and the
+// save format are unchanged, and references to values stay valid while
+// other keys are added or removed (iterators do not).
+class CrawlHashTable
 {
 public:
+    typedef pair<const string, CrawlStoreValue> value_type;
+    typedef size_t size_type;
+
+private:
+    typedef vector<unique_ptr<value_type>> entry_list;
+
+public:
+    template<typename V>
+    class iterator_base
+    {
+    public:
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef V                          value_type;
+        typedef ptrdiff_t                  difference_type;
+        typedef V*                         pointer;
+        typedef V&                         reference;
+
+        iterator_base() { }
+        // Lets an iterator convert to a const_iterator.
+        iterator_base(const iterator_base<CrawlHashTable::value_type> &other)
+            : it(other.it) { }
+
+        V &operator*() const  { return **it; }
+        V *operator->() const { return it->get(); }
+
+        iterator_base &operator++() { ++it; return *this; }
+        iterator_base &operator--() { --it; return *this; }
+        iterator_base operator++(int)
+        {
+            iterator_base copy = *this;
+            ++it;
+            return copy;
+        }
+        iterator_base operator--(int)
+        {
+            iterator_base copy = *this;
+            --it;
+            return copy;
+        }
+
+        bool operator==(const iterator_base &other) const
+        { return it == other.it; }
+        bool operator!=(const iterator_base &other) const
+        { return it != other.it; }
+
+    private:
+        explicit iterator_base(entry_list::const_iterator _it) : it(_it) { }
+
+        entry_list::const_iterator it;
+
+        friend class CrawlHashTable;
+        template<typename W> friend class iterator_base;
+    };
+    typedef iterator_base<value_type>       iterator;
+    typedef iterator_base<const value_type> const_iterator;
+
     friend class CrawlStoreValue;
 
+    CrawlHashTable();
+    CrawlHashTable(const CrawlHashTable &other);
+    CrawlHashTable(CrawlHashTable &&other) = default;
+    ~CrawlHashTable();
+
+    CrawlHashTable &operator = (const CrawlHashTable &other);
+    CrawlHashTable &operator = (CrawlHashTable &&other) = default;
+
     void write(writer &) const;
     void read(reader &);
 
-    bool exists(const string &key) const;
+    bool exists(const string &key) const
+    { return _find(key.data(), key.size()) >= 0; }
+    bool exists(const char *key) const
+    { return _find(key, strlen(key)) >= 0; }
 
     void assert_validity() const;
 
     // NOTE: If the const versions of get_value() or [] are given a
     // key which doesn't exist, they will assert.
-    const CrawlStoreValue& get_value(const string &key) const;
+    const CrawlStoreValue& get_value(const string &key) const
+    { return _get_value(key.data(), key.size()); }
     const CrawlStoreValue& get_value(const char *key) const
-    { return get_value(string(key)); }
+    { return _get_value(key, strlen(key)); }
     const CrawlStoreValue& operator[] (const string &key) const
     { return get_value(key); }
     const CrawlStoreValue& operator[] (const char *key) const
-    { return get_value(string(key)); }
+    { return get_value(key); }
 
     // NOTE: If get_value() or [] is given a key which doesn't exist
     // in the table, an unset/empty CrawlStoreValue will be created
@@ -270,12 +358,44 @@ public:
     // hash table has a type (rather than being heterogeneous)
     // then trying to assign a different type to the CrawlStoreValue
     // will assert.
-    CrawlStoreValue& get_value(const string &key);
+    CrawlStoreValue& get_value(const string &key)
+    { return _get_value(key.data(), key.size()); }
     CrawlStoreValue& get_value(const char *key)
-    { return get_value(string(key)); }
-    using map::operator[];
+    { return _get_value(key, strlen(key)); }
+    CrawlStoreValue& operator[] (const string &key)
+    { return get_value(key); }
     CrawlStoreValue& operator[] (const char *key)
-    { return get_value(string(key)); }
+    { return get_value(key); }
+
+    // std::map style interface
+    size_type size() const { return entries.size(); }
+    bool      empty() const { return entries.empty(); }
+    void      clear();
+
+    iterator       begin()       { return iterator(entries.begin()); }
+    iterator       end()         { return iterator(entries.end()); }
+    const_iterator begin() const { return const_iterator(entries.begin()); }
+    const_iterator end() const   { return const_iterator(entries.end()); }
+
+    iterator       find(const string &key);
+    const_iterator find(const string &key) const;
+    size_type      count(const string &key) const { return exists(key); }
+
+    iterator  erase(const_iterator pos);
+    size_type erase(const string &key)
+    { return _erase(key.data(), key.size()); }
+    size_type erase(const char *key)
+    { return _erase(key, strlen(key)); }
+
+private:
+    // Interned ids of the keys, in the same order as the entries.
+    vector<prop_key_id> ids;
+    entry_list entries;
+
+    int _find(const char *key, size_t len) const;
+    const CrawlStoreValue &_get_value(const char *key, size_t len) const;
+    CrawlStoreValue &_get_value(const char *key, size_t len);
+    size_type _erase(const char *key, size_t len);
 };
 
 // A CrawlVector is the vector version of CrawlHashTable, except that
@@ -18,6 +18,7 @@
 #include "tags.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -115,7 +116,8 @@ extern set<pair<string, level_id> > auto_unique_annotations;
 extern abyss_state abyssal_state;
 
 reader::reader(const string &_read_filename, int minorVersion)
-    : _filename(_read_filename), _chunk(0), _pbuf(nullptr), _read_offset(0),
+    : _filename(_read_filename), _pbuf(nullptr), _pbuf_len(0),
+      _read_offset(0),
       _minorVersion(minorVersion), _safe_read(false)
 {
     _file       = fopen_u(_filename.c_str(), "rb");
@@ -123,17 +125,24 @@ reader::reader(const string &_read_filename, int minorVersion)
 }
 
 reader::reader(package *save, const string &chunkname, int minorVersion)
-    : _file(0), _chunk(0), opened_file(false), _pbuf(0), _read_offset(0),
-     _minorVersion(minorVersion), _safe_read(false)
+    : _file(0), opened_file(false), _pbuf(0), _pbuf_len(0),
+      _read_offset(0), _minorVersion(minorVersion), _safe_read(false)
 {
     ASSERT(save);
-    _chunk = new chunk_reader(save, chunkname);
+    _kept = save->read_kept(chunkname);
+    if (_kept)
+    {
+        _pbuf = _kept->data();
+        _pbuf_len = _kept->size();
+        return;
+    }
+    chunk_reader(save, chunkname).read_all(_chunk_data);
+    _pbuf = _chunk_data.data();
+    _pbuf_len = _chunk_data.size();
 }
 
 reader::~reader()
 {
-    if (_chunk)
-        delete _chunk;
     close();
 }
 
@@ -146,6 +155,12 @@ void reader::close()
 
 void reader::advance(size_t offset)
 {
+    if (!_file)
+    {
+        read(nullptr, offset);
+        return;
+    }
+
     char junk[128];
 
     while (offset)
@@ -159,7 +174,7 @@ void reader::advance(size_t offset)
 bool reader::valid() const
 {
     return (_file && !feof(_file)) ||
-           (_pbuf && _read_offset < _pbuf->size());
+           (_pbuf && _read_offset < _pbuf_len);
 }
 
 static NORETURN void _short_read(bool safe_read)
@@ -171,8 +186,9 @@ static NORETURN void _short_read(bool safe_read)
     die_noline("short read while reading save");
 }
 
-// Reads input in network byte order, from a file or buffer.
-unsigned char reader::readByte()
+// Reads input in network byte order, from a file, or past the end of a
+// buffer; readByte() handles the rest of a buffer inline.
+unsigned char reader::_read_byte_slow()
 {
     if (_file)
     {
@@ -181,19 +197,7 @@ unsigned char reader::readByte()
             _short_read(_safe_read);
         return b;
     }
-    else if (_chunk)
-    {
-        unsigned char buf;
-        if (_chunk->read(&buf, 1) != 1)
-            _short_read(_safe_read);
-        return buf;
-    }
-    else
-    {
-        if (_read_offset >= _pbuf->size())
-            _short_read(_safe_read);
-        return (*_pbuf)[_read_offset++];
-    }
+    _short_read(_safe_read);
 }
 
 void reader::read(void *data, size_t size)
@@ -208,17 +212,12 @@ void reader::read(void *data, size_t size)
         else
             fseek(_file, (long)size, SEEK_CUR);
     }
-    else if (_chunk)
-    {
-        if (_chunk->read(data, size) != size)
-            _short_read(_safe_read);
-    }
     else
     {
-        if (_read_offset+size > _pbuf->size())
+        if (_read_offset+size > _pbuf_len)
             _short_read(_safe_read);
         if (data && size)
-            memcpy(data, &(*_pbuf)[_read_offset], size);
+            memcpy(data, &_pbuf[_read_offset], size);
 
         _read_offset += size;
     }
@@ -237,10 +236,7 @@ void reader::setMinorVersion(int minorVersion)
 
 void reader::fail_if_not_eof(const string &name)
 {
-    char dummy;
-    if (_chunk ? _chunk->read(&dummy, 1) :
-        _file ? (fgetc(_file) != EOF) :
-        _read_offset >= _pbuf->size())
+    if (_file ? (fgetc(_file) != EOF) : _read_offset < _pbuf_len)
     {
         fail("Incomplete read of \"%s\" - aborting.", name.c_str());
     }
@@ -787,33 +783,61 @@ static void _unmarshall_constriction(reader &th, actor *who)
 #endif
 }
 
-template <typename marshall, typename grid>
-static void _run_length_encode(writer &th, marshall m, const grid &g,
-                               int width, int height)
-{
-    int last = 0, nlast = 0;
-    for (int y = 0; y < height; ++y)
-        for (int x = 0; x < width; ++x)
-        {
-            if (!nlast)
-                last = g[x][y];
-            if (last == g[x][y] && nlast < 255)
-            {
-                nlast++;
-                continue;
-            }
-
-            marshallByte(th, nlast);
-            m(th, last);
-
-            last = g[x][y];
-            nlast = 1;
-        }
-
-    marshallByte(th, nlast);
-    m(th, last);
+/**
+ * Marshall one column of a level grid.
+ *
+ * The column is cut into runs of equal values. Each run is written as one
+ * unsigned varint that packs its length together with the difference from
+ * the value of the run before it, zigzagged so that small negative
+ * differences stay small: zigzag(delta) * height + length - 1. Terrain,
+ * colours, flags and tile indices mostly change in small steps, if at all,
+ * so a run usually takes one or two bytes.
+ *
+ * @param last  The value of the previous run, which carries over from one
+ *              column to the next. Updated to the value of the last run.
+ */
+void marshall_grid_column(writer &th, const int32_t *column, int height,
+                          int32_t &last)
+{
+    int y = 0;
+    while (y < height)
+    {
+        const int32_t value = column[y];
+        int run = 1;
+        while (y + run < height && column[y + run] == value)
+            ++run;
+
+        const int64_t delta = (int64_t)value - last;
+        const uint64_t zigzag = delta < 0 ? ((uint64_t)(-delta - 1) << 1) | 1
+                                          : (uint64_t)delta << 1;
+        marshallUnsigned(th, zigzag * height + run - 1);
+
+        last = value;
+        y += run;
+    }
+}
+
+void unmarshall_grid_column(reader &th, int32_t *column, int height,
+                            int32_t &last)
+{
+    int y = 0;
+    while (y < height)
+    {
+        const uint64_t packed = unmarshallUnsigned(th);
+        const int run = packed % height + 1;
+        const uint64_t zigzag = packed / height;
+        const int64_t delta = zigzag & 1 ? -(int64_t)(zigzag >> 1) - 1
+                                         : (int64_t)(zigzag >> 1);
+        if (y + run > height)
+            die("save corrupted: grid run past the end of a column");
+
+        last = (int32_t)(last + delta);
+        for (int i = 0; i < run; ++i)
+            column[y++] = last;
+    }
 }
 
+#if TAG_MAJOR_VERSION == 34
 template <typename unmarshall, typename grid>
 static void _run_length_decode(reader &th, unmarshall um, grid &g,
                                int width, int height)
@@ -834,6 +858,7 @@ static void _run_length_decode(reader &th, unmarshall um, grid &g,
         }
     }
 }
+#endif
 
 union float_marshall_kludge
 {
@@ -1238,6 +1263,45 @@ static void _add_missing_branches()
 }
 #endif
 
+static tag_profile *_tag_profile = nullptr;
+
+void tag_set_profile(tag_profile *profile)
+{
+    _tag_profile = profile;
+}
+
+// Adds the bytes written and the time taken while it is in scope to a
+// section of the current tag profile, if there is one. Only tag_write()
+// writes while a profile is set, so th is always a memory buffer.
+class tag_profile_section
+{
+public:
+    tag_profile_section(writer &_th, const char *_name)
+        : th(_th), name(_name), start_pos(0)
+    {
+        if (!_tag_profile)
+            return;
+        start_pos = th.tell();
+        start = chrono::steady_clock::now();
+    }
+
+    ~tag_profile_section()
+    {
+        if (!_tag_profile)
+            return;
+        tag_section_stats &stats = (*_tag_profile)[name];
+        stats.calls++;
+        stats.bytes += th.tell() - start_pos;
+        stats.usec += chrono::duration<double, micro>(
+                          chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    writer &th;
+    const char *name;
+    long start_pos;
+    chrono::steady_clock::time_point start;
+};
 
 // Write a tagged chunk of data to the FILE*.
 // tagId specifies what to write.
@@ -1474,6 +1538,7 @@ void tag_read(reader &inf, tag_type tag_id)
 
 static void _tag_construct_char(writer &th)
 {
+    tag_profile_section section(th, "char");
     marshallByte(th, TAG_CHR_FORMAT);
     // Important: you may never remove or alter a field without bumping
     // CHR_FORMAT. Bumping it makes all saves invisible when browsed in an
@@ -1519,6 +1584,7 @@ static bool _calc_score_exists()
 
 static void _tag_construct_you(writer &th)
 {
+    tag_profile_section section(th, "you");
     marshallInt(th, you.last_mid);
     marshallByte(th, you.piety);
     marshallShort(th, you.pet_target);
@@ -1820,11 +1886,15 @@ static void _tag_construct_you(writer &th)
     revision += Version::Long;
     marshallString(th, revision);
 
-    you.props.write(th);
+    {
+        tag_profile_section props(th, "you props");
+        you.props.write(th);
+    }
 }
 
 static void _tag_construct_you_items(writer &th)
 {
+    tag_profile_section section(th, "you items");
     // ENDOFPACK is the end of our real inventory, but there is one hidden slot
     // after that to temporarily hold items for examining items, so it's
     // important not to marshall the entire array.
@@ -1921,6 +1991,7 @@ static void marshallLevelXPInfo(writer &th, LevelXPInfo xp_info)
 
 static void _tag_construct_you_dungeon(writer &th)
 {
+    tag_profile_section section(th, "you dungeon");
     // how many unique creatures?
     marshallShort(th, NUM_MONSTERS);
     for (int j = 0; j < NUM_MONSTERS; ++j)
@@ -2357,12 +2428,14 @@ void ShopInfo::load(reader& inf)
 
 static void _tag_construct_lost_monsters(writer &th)
 {
+    tag_profile_section section(th, "lost monsters");
     marshallMap(th, the_lost_ones, marshall_level_id,
                  marshall_follower_list);
 }
 
 static void _tag_construct_companions(writer &th)
 {
+    tag_profile_section section(th, "companions");
 #if TAG_MAJOR_VERSION == 34
     fixup_bad_companions();
 #endif
@@ -5062,8 +5135,25 @@ static int _last_used_index(const Z &thinglist, int max_things)
 
 // ------------------------------- level tags ---------------------------- //
 
+// The terrain, terrain properties and map knowledge of the current level.
+void marshall_level_grids(writer &th)
+{
+    marshall_grid(th, env.grid);
+    marshall_grid(th, env.pgrid, [](const terrain_property_t &prop)
+                                 { return (int32_t)prop.flags; });
+    for (int count_x = 0; count_x < GXM; count_x++)
+        for (int count_y = 0; count_y < GYM; count_y++)
+            marshallMapCell(th, env.map_knowledge[count_x][count_y]);
+}
+
+void marshall_level_colours(writer &th)
+{
+    marshall_grid(th, env.grid_colours);
+}
+
 static void _tag_construct_level(writer &th)
 {
+    tag_profile_section section(th, "level");
     marshallByte(th, env.floor_colour);
     marshallByte(th, env.rock_colour);
 
@@ -5080,21 +5170,18 @@ static void _tag_construct_level(writer &th)
 
     CANARY;
 
-    for (int count_x = 0; count_x < GXM; count_x++)
-        for (int count_y = 0; count_y < GYM; count_y++)
-        {
-            marshallByte(th, env.grid[count_x][count_y]);
-            marshallMapCell(th, env.map_knowledge[count_x][count_y]);
-            marshallInt(th, env.pgrid[count_x][count_y].flags);
-        }
+    {
+        tag_profile_section grids(th, "level grids");
+        marshall_level_grids(th);
 
-    marshallBoolean(th, !!env.map_forgotten);
-    if (env.map_forgotten)
-        for (int x = 0; x < GXM; x++)
-            for (int y = 0; y < GYM; y++)
-                marshallMapCell(th, (*env.map_forgotten)[x][y]);
+        marshallBoolean(th, !!env.map_forgotten);
+        if (env.map_forgotten)
+            for (int x = 0; x < GXM; x++)
+                for (int y = 0; y < GYM; y++)
+                    marshallMapCell(th, (*env.map_forgotten)[x][y]);
 
-    _run_length_encode(th, marshallByte, env.grid_colours, GXM, GYM);
+        marshall_level_colours(th);
+    }
 
     CANARY;
 
@@ -5129,7 +5216,10 @@ static void _tag_construct_level(writer &th)
     marshallByte(th, env.sanctuary_time);
 
     env.markers.write(th);
-    env.properties.write(th);
+    {
+        tag_profile_section props(th, "level props");
+        env.properties.write(th);
+    }
 
     marshallInt(th, env.dactions_done);
 
@@ -5194,7 +5284,10 @@ void marshallItem(writer &th, const item_def &item, bool iinfo)
     marshallShort(th, item.orig_monnum);
     marshallString(th, item.inscription);
 
-    item.props.write(th);
+    {
+        tag_profile_section props(th, "item props");
+        item.props.write(th);
+    }
 }
 
 #if TAG_MAJOR_VERSION == 34
@@ -6006,6 +6099,7 @@ void unmarshallMapCell(reader &th, map_cell& cell)
 
 static void _tag_construct_level_items(writer &th)
 {
+    tag_profile_section section(th, "level items");
     // how many traps?
     marshallShort(th, env.trap.size());
     for (const auto& entry : env.trap)
@@ -6138,7 +6232,10 @@ void marshallMonster(writer &th, const monster& m)
     if (parts & MP_CONSTRICTION)
         _marshall_constriction(th, &m);
 
-    m.props.write(th);
+    {
+        tag_profile_section props(th, "monster props");
+        m.props.write(th);
+    }
 }
 
 static void _marshall_mi_attack(writer &th, const mon_attack_def &attk)
@@ -6211,7 +6308,10 @@ void _marshallMonsterInfo(writer &th, const monster_info& mi)
         marshallShort(th, mi.i_ghost.ac);
     }
 
-    mi.props.write(th);
+    {
+        tag_profile_section props(th, "monster info props");
+        mi.props.write(th);
+    }
 }
 
 void _unmarshallMonsterInfo(reader &th, monster_info& mi)
@@ -6518,6 +6618,7 @@ void _unmarshallMonsterInfo(reader &th, monster_info& mi)
 
 static void _tag_construct_level_monsters(writer &th)
 {
+    tag_profile_section section(th, "level monsters");
     int nm = 0;
     for (int i = 0; i < MAX_MONS_ALLOC; ++i)
         if (env.mons_alloc[i] != MONS_NO_MONSTER)
@@ -6557,8 +6658,28 @@ static void _tag_construct_level_monsters(writer &th)
     }
 }
 
+void marshall_tile_flavours(writer &th)
+{
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.wall_idx; });
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.floor_idx; });
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.feat_idx; });
+
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.wall; });
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.floor; });
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.feat; });
+    marshall_grid(th, tile_env.flv, [](const tile_flavour &flv)
+                                    { return flv.special; });
+}
+
 void _tag_construct_level_tiles(writer &th)
 {
+    tag_profile_section section(th, "level tiles");
     // Map grids.
     // how many X?
     marshallShort(th, GXM);
@@ -6582,22 +6703,51 @@ void _tag_construct_level_tiles(writer &th)
     marshallShort(th, tile_env.default_flavour.floor);
     marshallShort(th, tile_env.default_flavour.special);
 
-    for (int count_x = 0; count_x < GXM; count_x++)
-        for (int count_y = 0; count_y < GYM; count_y++)
-        {
-            marshallShort(th, tile_env.flv[count_x][count_y].wall_idx);
-            marshallShort(th, tile_env.flv[count_x][count_y].floor_idx);
-            marshallShort(th, tile_env.flv[count_x][count_y].feat_idx);
-
-            marshallShort(th, tile_env.flv[count_x][count_y].wall);
-            marshallShort(th, tile_env.flv[count_x][count_y].floor);
-            marshallShort(th, tile_env.flv[count_x][count_y].feat);
-            marshallShort(th, tile_env.flv[count_x][count_y].special);
-        }
+    marshall_tile_flavours(th);
 
     marshallInt(th, TILE_WALL_MAX);
 }
 
+// Read what marshall_level_grids() wrote, or the cell by cell layout of
+// older saves.
+void unmarshall_level_grids(reader &th)
+{
+#if TAG_MAJOR_VERSION == 34
+    if (th.getMinorVersion() < TAG_MINOR_COLUMN_GRIDS)
+    {
+        for (int i = 0; i < GXM; i++)
+            for (int j = 0; j < GYM; j++)
+            {
+                env.grid[i][j] = unmarshallFeatureType(th);
+                unmarshallMapCell(th, env.map_knowledge[i][j]);
+                env.pgrid[i][j].flags = unmarshallInt(th);
+            }
+        return;
+    }
+#endif
+    unmarshall_grid(th, env.grid);
+    unmarshall_grid(th, env.pgrid, [](terrain_property_t &prop, int32_t v)
+                                   { prop.flags = v; });
+    for (int i = 0; i < GXM; i++)
+        for (int j = 0; j < GYM; j++)
+            unmarshallMapCell(th, env.map_knowledge[i][j]);
+}
+
+// Read what marshall_level_colours() wrote, or the row-major run-length
+// encoding of older saves.
+void unmarshall_level_colours(reader &th)
+{
+    env.grid_colours.init(BLACK);
+#if TAG_MAJOR_VERSION == 34
+    if (th.getMinorVersion() < TAG_MINOR_COLUMN_GRIDS)
+    {
+        _run_length_decode(th, unmarshallByte, env.grid_colours, GXM, GYM);
+        return;
+    }
+#endif
+    unmarshall_grid(th, env.grid_colours);
+}
+
 static void _tag_read_level(reader &th)
 {
     env.floor_colour = unmarshallUByte(th);
@@ -6624,6 +6774,8 @@ static void _tag_read_level(reader &th)
 
     EAT_CANARY;
 
+    unmarshall_level_grids(th);
+
     env.map_seen.reset();
 #if TAG_MAJOR_VERSION == 34
     vector<coord_def> transporters;
@@ -6631,16 +6783,13 @@ static void _tag_read_level(reader &th)
     for (int i = 0; i < gx; i++)
         for (int j = 0; j < gy; j++)
         {
-            dungeon_feature_type feat = unmarshallFeatureType(th);
-            env.grid[i][j] = feat;
-            ASSERT(feat < NUM_FEATURES);
+            ASSERT(env.grid[i][j] < NUM_FEATURES);
 
 #if TAG_MAJOR_VERSION == 34
             // Save these for potential destination clean up.
             if (env.grid[i][j] == DNGN_TRANSPORTER)
                 transporters.push_back(coord_def(i, j));
 #endif
-            unmarshallMapCell(th, env.map_knowledge[i][j]);
             // Fixup positions
             if (env.map_knowledge[i][j].monsterinfo())
                 env.map_knowledge[i][j].monsterinfo()->pos = coord_def(i, j);
@@ -6650,7 +6799,6 @@ static void _tag_read_level(reader &th)
             env.map_knowledge[i][j].flags &= ~MAP_VISIBLE_FLAG;
             if (env.map_knowledge[i][j].seen())
                 env.map_seen.set(i, j);
-            env.pgrid[i][j].flags = unmarshallInt(th);
 
             env.mgrid[i][j] = NON_MONSTER;
         }
@@ -6671,8 +6819,7 @@ static void _tag_read_level(reader &th)
     else
         env.map_forgotten.reset();
 
-    env.grid_colours.init(BLACK);
-    _run_length_decode(th, unmarshallByte, env.grid_colours, GXM, GYM);
+    unmarshall_level_colours(th);
 
     EAT_CANARY;
 
@@ -7641,6 +7788,47 @@ static void _debug_count_tiles()
 #endif
 }
 
+// Read what marshall_tile_flavours() wrote, or the cell by cell layout of
+// older saves.
+void unmarshall_tile_flavours(reader &th)
+{
+#if TAG_MAJOR_VERSION == 34
+    if (th.getMinorVersion() < TAG_MINOR_COLUMN_GRIDS)
+    {
+        for (int x = 0; x < GXM; x++)
+            for (int y = 0; y < GYM; y++)
+            {
+                tile_env.flv[x][y].wall_idx  = unmarshallShort(th);
+                tile_env.flv[x][y].floor_idx = unmarshallShort(th);
+                tile_env.flv[x][y].feat_idx  = unmarshallShort(th);
+
+                // These get overwritten by _regenerate_tile_flavour
+                tile_env.flv[x][y].wall    = unmarshallShort(th);
+                tile_env.flv[x][y].floor   = unmarshallShort(th);
+                tile_env.flv[x][y].feat    = unmarshallShort(th);
+                tile_env.flv[x][y].special = unmarshallShort(th);
+            }
+        return;
+    }
+#endif
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.wall_idx = v; });
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.floor_idx = v; });
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.feat_idx = v; });
+
+    // These get overwritten by _regenerate_tile_flavour
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.wall = v; });
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.floor = v; });
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.feat = v; });
+    unmarshall_grid(th, tile_env.flv, [](tile_flavour &flv, int32_t v)
+                                      { flv.special = v; });
+}
+
 void _tag_read_level_tiles(reader &th)
 {
     // Map grids.
@@ -7669,19 +7857,9 @@ void _tag_read_level_tiles(reader &th)
     tile_env.default_flavour.floor     = unmarshallShort(th);
     tile_env.default_flavour.special   = unmarshallShort(th);
 
-    for (int x = 0; x < gx; x++)
-        for (int y = 0; y < gy; y++)
-        {
-            tile_env.flv[x][y].wall_idx  = unmarshallShort(th);
-            tile_env.flv[x][y].floor_idx = unmarshallShort(th);
-            tile_env.flv[x][y].feat_idx  = unmarshallShort(th);
-
-            // These get overwritten by _regenerate_tile_flavour
-            tile_env.flv[x][y].wall    = unmarshallShort(th);
-            tile_env.flv[x][y].floor   = unmarshallShort(th);
-            tile_env.flv[x][y].feat    = unmarshallShort(th);
-            tile_env.flv[x][y].special = unmarshallShort(th);
-        }
+    ASSERT(gx == GXM);
+    ASSERT(gy == GYM);
+    unmarshall_tile_flavours(th);
 
     _debug_count_tiles();
 
@@ -13,6 +13,7 @@
 #include "debug.h"
 #include "defines.h"
 #include "dungeon-feature-type.h"
+#include "fixedarray.h"
 #include "fixedvector.h"
 #include "level-id.h"
 #include "package.h"
@@ -54,22 +55,38 @@ class writer
 public:
     writer(const string &filename, FILE* output, bool ignore_errors = false)
         : _filename(filename), _file(output), _chunk(0),
-          _ignore_errors(ignore_errors), _pbuf(0), failed(false)
+          _ignore_errors(ignore_errors), _pbuf(0), _defer_save(0),
+          failed(false)
     {
         ASSERT(output);
     }
     writer(vector<unsigned char>* poutput)
         : _filename(), _file(0), _chunk(0), _ignore_errors(false),
-          _pbuf(poutput), failed(false) { ASSERT(poutput); }
-    writer(package *save, const string &chunkname)
+          _pbuf(poutput), _defer_save(0), failed(false) { ASSERT(poutput); }
+    // With defer, the chunk is only marshalled here, and is compressed and
+    // written by the next commit of the package (see package::write_later).
+    writer(package *save, const string &chunkname, bool defer = false)
         : _filename(), _file(0), _chunk(0), _ignore_errors(false),
-          failed(false)
+          _pbuf(0), _defer_save(0), failed(false)
     {
         ASSERT(save);
-        _chunk = save->writer(chunkname);
+        if (defer)
+        {
+            _defer_save = save;
+            _chunkname = chunkname;
+            _pbuf = &_deferred;
+        }
+        else
+            _chunk = save->writer(chunkname);
     }
 
-    ~writer() { if (_chunk) delete _chunk; }
+    ~writer()
+    {
+        if (_chunk)
+            delete _chunk;
+        if (_defer_save)
+            _defer_save->write_later(_chunkname, _deferred);
+    }
 
     void writeByte(unsigned char byte);
     void write(const void *data, size_t size);
@@ -88,6 +105,10 @@ private:
 
     vector<unsigned char>* _pbuf;
 
+    package *_defer_save;
+    string _chunkname;
+    vector<unsigned char> _deferred;
+
     bool failed;
 };
 
@@ -115,17 +136,31 @@ class reader
 public:
     reader(const string &filename, int minorVersion = TAG_MINOR_INVALID);
     reader(FILE* input, int minorVersion = TAG_MINOR_INVALID)
-        : _file(input), _chunk(0), opened_file(false), _pbuf(0),
+        : _file(input), opened_file(false), _pbuf(0), _pbuf_len(0),
           _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
     reader(const vector<unsigned char>& input,
            int minorVersion = TAG_MINOR_INVALID)
-        : _file(0), _chunk(0), opened_file(false), _pbuf(&input),
-          _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+        : _file(0), opened_file(false), _pbuf(input.data()),
+          _pbuf_len(input.size()), _read_offset(0),
+          _minorVersion(minorVersion), _safe_read(false) {}
+    // Read from memory owned by someone else, e.g. a mapped file.
+    reader(const unsigned char *input, size_t len,
+           int minorVersion = TAG_MINOR_INVALID)
+        : _file(0), opened_file(false), _pbuf(input),
+          _pbuf_len(len), _read_offset(0), _minorVersion(minorVersion),
+          _safe_read(false) { ASSERT(input || !len); }
+    // Decompresses the whole chunk up front and reads it from memory, or
+    // reads the contents kept by package::keep_in_memory() in place.
     reader(package *save, const string &chunkname,
            int minorVersion = TAG_MINOR_INVALID);
     ~reader();
 
-    unsigned char readByte();
+    unsigned char readByte()
+    {
+        if (_read_offset < _pbuf_len)
+            return _pbuf[_read_offset++];
+        return _read_byte_slow();
+    }
     void read(void *data, size_t size);
     void advance(size_t size);
     int getMinorVersion() const;
@@ -139,12 +174,18 @@ public:
     void set_safe_read(bool setting) { _safe_read = setting; }
 
 private:
+    unsigned char _read_byte_slow();
+
     string _filename;
     FILE* _file;
-    chunk_reader *_chunk;
     bool  opened_file;
-    const vector<unsigned char>* _pbuf;
-    unsigned int _read_offset;
+    // The decompressed data of a save chunk, which _pbuf points into.
+    vector<unsigned char> _chunk_data;
+    // Or the contents the package kept in memory.
+    chunk_data_ptr _kept;
+    const unsigned char* _pbuf;
+    size_t _pbuf_len;
+    size_t _read_offset;
     int _minorVersion;
     // always throw an exception rather than dying when reading past EOF
     bool _safe_read;
@@ -183,8 +224,63 @@ static inline void unmarshallSigned(reader& th, T& v)
 void marshallMapCell (writer &, const map_cell &);
 void unmarshallMapCell (reader &, map_cell& cell);
 
+void marshall_grid_column(writer &th, const int32_t *column, int height,
+                          int32_t &last);
+void unmarshall_grid_column(reader &th, int32_t *column, int height,
+                            int32_t &last);
+
+// Marshall a whole grid column by column (see marshall_grid_column()), using
+// get to turn each cell into an integer.
+template<typename T, int WIDTH, int HEIGHT, typename F>
+void marshall_grid(writer &th, const FixedArray<T, WIDTH, HEIGHT> &grid,
+                   F get)
+{
+    int32_t column[HEIGHT];
+    int32_t last = 0;
+    for (int x = 0; x < WIDTH; ++x)
+    {
+        for (int y = 0; y < HEIGHT; ++y)
+            column[y] = get(grid[x][y]);
+        marshall_grid_column(th, column, HEIGHT, last);
+    }
+}
+
+template<typename T, int WIDTH, int HEIGHT>
+void marshall_grid(writer &th, const FixedArray<T, WIDTH, HEIGHT> &grid)
+{
+    marshall_grid(th, grid, [](const T &cell) { return (int32_t)cell; });
+}
+
+// Read a grid written by marshall_grid(), using set to store each value.
+template<typename T, int WIDTH, int HEIGHT, typename F>
+void unmarshall_grid(reader &th, FixedArray<T, WIDTH, HEIGHT> &grid, F set)
+{
+    int32_t column[HEIGHT];
+    int32_t last = 0;
+    for (int x = 0; x < WIDTH; ++x)
+    {
+        unmarshall_grid_column(th, column, HEIGHT, last);
+        for (int y = 0; y < HEIGHT; ++y)
+            set(grid[x][y], column[y]);
+    }
+}
+
+template<typename T, int WIDTH, int HEIGHT>
+void unmarshall_grid(reader &th, FixedArray<T, WIDTH, HEIGHT> &grid)
+{
+    unmarshall_grid(th, grid, [](T &cell, int32_t v) { cell = (T)v; });
+}
+
 FixedVector<spell_type, MAX_KNOWN_SPELLS> unmarshall_player_spells(reader &th);
 
+// The grids of the current level, as saved in its chunk.
+void marshall_level_grids(writer &th);
+void unmarshall_level_grids(reader &th);
+void marshall_level_colours(writer &th);
+void unmarshall_level_colours(reader &th);
+void marshall_tile_flavours(writer &th);
+void unmarshall_tile_flavours(reader &th);
+
 void unmarshallSpells(reader &, monster_spells &
 #if TAG_MAJOR_VERSION == 34
                              , unsigned hd
@@ -210,6 +306,21 @@ player_save_info tag_read_char_info(reader &th, uint8_t format, uint8_t major,
 vector<ghost_demon> tag_read_ghosts(reader &th);
 void tag_write_ghosts(writer &th, const vector<ghost_demon> &ghosts);
 
+// The cost of one section of the tags written while profiling. Sections
+// nest: props tables are also counted in the section that wrote them.
+struct tag_section_stats
+{
+    int calls = 0;
+    uint64_t bytes = 0;
+    double usec = 0;
+};
+
+typedef map<string, tag_section_stats> tag_profile;
+
+// While set, tag_write() adds the size and marshalling time of each section
+// it writes to *profile. Used by --save-stats.
+void tag_set_profile(tag_profile *profile);
+
 /* ***********************************************************************
  * misc
  * *********************************************************************** */
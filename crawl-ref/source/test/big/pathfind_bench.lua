@@ -0,0 +1,95 @@
+-- Compare monster pathfinding with and without the cluster graph, on the
+-- debug_pathfind maps and on some generated levels. For each search, report
+-- the path length, the nodes expanded and the time taken. The first cluster
+-- search on a level includes building the graph; the second reuses it.
+--
+-- Paths through the cluster graph may be a little longer than the A* ones,
+-- but must exist whenever A* finds one.
+
+local eol = string.char(13)
+local totals = { astar = { exp = 0, usec = 0 }, cold = { exp = 0, usec = 0 },
+                 warm = { exp = 0, usec = 0 } }
+
+local function add(which, exp, usec)
+  totals[which].exp = totals[which].exp + exp
+  totals[which].usec = totals[which].usec + usec
+end
+
+local function bench(name, mx, my, tx, ty)
+  local alen, aexp, ausec = debug.pathfind(mx, my, tx, ty, false)
+  local clen, cexp, cusec = debug.pathfind(mx, my, tx, ty, true)
+  local wlen, wexp, wusec = debug.pathfind(mx, my, tx, ty, true)
+
+  test.map_assert(not alen == not wlen,
+                  name .. ": A* found " .. tostring(alen)
+                    .. " steps but the cluster graph " .. tostring(wlen))
+  add("astar", aexp, ausec)
+  add("cold", cexp, cusec)
+  add("warm", wexp, wusec)
+
+  crawl.stderr(string.format(
+    "%-24s A*: %5s steps %6d nodes %7d us | clusters: %5s steps "
+      .. "%6d/%6d nodes %7d/%7d us" .. eol,
+    name, tostring(alen), aexp, ausec, tostring(wlen), cexp, wexp,
+    cusec, wusec))
+end
+
+local function find_orc()
+  local function has_orc(p)
+    local mons = dgn.mons_at(p.x, p.y)
+    return mons and mons.name == "orc"
+  end
+  return dgn.find_points(has_orc)[1]
+end
+
+local function bench_maps()
+  for _, name in ipairs({ "pathfind_hall", "pathfind_clear_maze",
+                          "pathfind_corridors" }) do
+    dgn.reset_level()
+    debug.los_changed()
+    assert(dgn.place_map(dgn.map_by_name(name), true, true),
+           "Could not place " .. name)
+    local target = test.find_feature("stone_stairs_up_i")
+    local mons = find_orc()
+    assert(target and mons, "No monster or target in " .. name)
+    bench(name, mons.x, mons.y, target.x, target.y)
+  end
+end
+
+local function random_floor()
+  local x, y
+  repeat
+    x = crawl.random_range(1, dgn.GXM - 2)
+    y = crawl.random_range(1, dgn.GYM - 2)
+  until feat.has_solid_floor(x, y) and not dgn.mons_at(x, y)
+  return x, y
+end
+
+local function bench_levels(depth, searches)
+  local place = "D:" .. depth
+  test.regenerate_level(place)
+  debug.dismiss_monsters()
+  debug.los_changed()
+  for i = 1, searches do
+    local mx, my = random_floor()
+    local tx, ty
+    repeat
+      tx, ty = random_floor()
+    until math.max(math.abs(tx - mx), math.abs(ty - my)) >= 30
+    local mons = dgn.create_monster(mx, my, "orc")
+    if mons then
+      bench(place .. " #" .. i, mx, my, tx, ty)
+      debug.dismiss_monsters()
+    end
+  end
+end
+
+bench_maps()
+for depth = 1, 15 do
+  bench_levels(depth, 5)
+end
+
+for _, which in ipairs({ "astar", "cold", "warm" }) do
+  crawl.stderr(string.format("%-8s %8d nodes %9d us" .. eol, which,
+                             totals[which].exp, totals[which].usec))
+end
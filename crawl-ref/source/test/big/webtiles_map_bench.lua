@@ -0,0 +1,74 @@
+-- Compare the size and cost of webtiles map updates sent as JSON with those
+-- using packed map cells. The player walks the same travel routes on the same
+-- levels once for each encoding, and we report the bytes and the time spent
+-- building the map message per turn. Only meaningful in webtiles builds.
+
+local eol = string.char(13)
+
+if not debug.webtiles_map_bench then
+  crawl.stderr("webtiles_map_bench: not a webtiles build, skipping" .. eol)
+  return
+end
+
+local function random_floor()
+  local x, y
+  repeat
+    x = crawl.random_range(1, dgn.GXM - 2)
+    y = crawl.random_range(1, dgn.GYM - 2)
+  until feat.has_solid_floor(x, y) and not feat.is_water(x, y)
+        and not dgn.mons_at(x, y)
+  return x, y
+end
+
+local function walk(encoding, total, tx, ty)
+  for step = 1, 200 do
+    local x, y = you.pos()
+    if x == tx and y == ty then
+      return
+    end
+    local mx, my = debug.travel_move(tx, ty)
+    if not mx then
+      return
+    end
+    you.moveto(mx, my)
+    debug.viewwindow(false)
+    local bytes, usec = debug.webtiles_map_bench(encoding)
+    total.turns = total.turns + 1
+    total.bytes = total.bytes + bytes
+    total.usec = total.usec + usec
+  end
+end
+
+local function bench(encoding)
+  local total = { turns = 0, bytes = 0, usec = 0, full_bytes = 0,
+                  full_usec = 0 }
+  debug.reset_rng(1)
+  for depth = 1, 8 do
+    test.regenerate_level("D:" .. depth)
+    debug.dismiss_monsters()
+    debug.magic_mapping()
+    you.moveto(random_floor())
+    debug.viewwindow(false)
+    local bytes, usec = debug.webtiles_map_bench(encoding, true)
+    total.full_bytes = total.full_bytes + bytes
+    total.full_usec = total.full_usec + usec
+    for i = 1, 3 do
+      walk(encoding, total, random_floor())
+    end
+  end
+  return total
+end
+
+local json = bench(0)
+local packed = bench(1)
+assert(json.turns == packed.turns, "the two walks took different routes")
+assert(packed.bytes <= json.bytes, "packed map updates were larger")
+
+for _, row in ipairs({ { "json", json }, { "packed", packed } }) do
+  local name, t = row[1], row[2]
+  crawl.stderr(string.format(
+    "%-7s %5d turns %8.1f bytes/turn %7.1f us/turn | full maps: "
+      .. "%8d bytes %7d us" .. eol,
+    name, t.turns, t.bytes / math.max(t.turns, 1),
+    t.usec / math.max(t.turns, 1), t.full_bytes, t.full_usec))
+end
@@ -0,0 +1,105 @@
+-- Check that local terrain changes keep the cell_see_cell cache correct:
+-- only the affected pairs are dropped, and everything we still answer
+-- from the cache must match a full recomputation.
+
+local FAILMAP = 'loscache.map'
+local checks = 0
+
+local function see_around(cx, cy)
+  local seen = { }
+  for y = -8, 8 do
+    for x = -8, 8 do
+      local px, py = cx + x, cy + y
+      if dgn.in_bounds(px, py) then
+        seen[x .. "," .. y] = los.cell_see_cell(cx, cy, px, py)
+      end
+    end
+  end
+  return seen
+end
+
+local function compare(cx, cy, cached, fresh)
+  for k, v in pairs(fresh) do
+    if cached[k] ~= v then
+      dgn.fprop_changed(cx, cy, "highlight")
+      debug.dump_map(FAILMAP)
+      assert(false,
+             "stale cell_see_cell cache (iter #" .. checks .. ") at "
+               .. dgn.point(cx, cy) .. " offset " .. k
+               .. ". Map saved to " .. FAILMAP)
+    end
+  end
+end
+
+local function test_local_invalidation()
+  you.random_teleport()
+  checks = checks + 1
+  local you_x, you_y = you.pos()
+
+  -- Fill the cache around the player.
+  see_around(you_x, you_y)
+
+  -- Toggle a few cells near the player between wall and floor.
+  local flushes = los.cache_stats("total").flushes
+  for i = 1, 4 do
+    local x = you_x + crawl.random_range(-6, 6)
+    local y = you_y + crawl.random_range(-6, 6)
+    if (x ~= you_x or y ~= you_y) and dgn.in_bounds(x, y)
+       and not dgn.mons_at(x, y) then
+      if feat.is_wall(x, y) then
+        dgn.grid(x, y, "floor")
+      else
+        dgn.grid(x, y, "rock_wall")
+      end
+    end
+  end
+  assert(los.cache_stats("total").flushes == flushes,
+         "local terrain change flushed the whole LOS cache")
+
+  local centres = { { you_x, you_y }, { you_x + 3, you_y - 2 },
+                    { you_x - 4, you_y + 1 } }
+  local cached = { }
+  for i, c in ipairs(centres) do
+    if dgn.in_bounds(c[1], c[2]) then
+      cached[i] = see_around(c[1], c[2])
+    end
+  end
+
+  -- Asking again without an opacity change is answered from the cache.
+  local before = los.cache_stats("total")
+  see_around(you_x, you_y)
+  local after = los.cache_stats("total")
+  assert(after.misses == before.misses and after.hits > before.hits,
+         "LOS was recomputed without an opacity change")
+
+  debug.los_changed()
+  for i, c in ipairs(centres) do
+    if cached[i] then
+      compare(c[1], c[2], cached[i], see_around(c[1], c[2]))
+    end
+  end
+end
+
+local function run_los_tests(depth, nlevels, tests_per_level)
+  local place = "D:" .. depth
+  crawl.message("Running LOS cache tests on " .. place)
+  debug.goto_place(place)
+
+  for lev_i = 1, nlevels do
+    debug.flush_map_memory()
+    debug.generate_level()
+    for t_i = 1, tests_per_level do
+      test_local_invalidation()
+    end
+  end
+end
+
+local start = los.cache_stats("total")
+for depth = 1, 15 do
+  run_los_tests(depth, 1, 3)
+end
+local stats = los.cache_stats("total")
+local hits = stats.hits - start.hits
+local misses = stats.misses - start.misses
+crawl.message(string.format("LOS cache hit rate: %d/%d (%.1f%%)", hits,
+                            hits + misses, 100 * hits / (hits + misses)))
@@ -10,11 +10,13 @@ local function test_cellseecell_symmetry()
 
   checks = checks + 1
   local you_x, you_y = you.pos()
+  test.check_los_engines(you_x, you_y, FAILMAP, checks)
 
   for y = -9, 9 do
     for x = -9, 9 do
       local px, py = x + you_x, y + you_y
       if (x ~= 0 or y ~= 0) and dgn.in_bounds(px, py) then
+        test.check_los_engines(px, py, FAILMAP, checks)
         local forward = los.cell_see_cell(you_x, you_y, px, py)
         local backward = los.cell_see_cell(px, py, you_x, you_y)
         this_p = dgn.point(you_x, you_y)
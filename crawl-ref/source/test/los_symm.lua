@@ -9,6 +9,7 @@ local function test_losight_symmetry()
 
   checks = checks + 1
   local you_x, you_y = you.pos()
+  test.check_los_engines(you_x, you_y, FAILMAP, checks)
 
   local visible_spots = { }
   for y = -8, 8 do
@@ -29,6 +30,7 @@ local function test_losight_symmetry()
   for _, spot in ipairs(visible_spots) do
     local x, y = unpack(spot)
     you.moveto(x, y)
+    test.check_los_engines(x, y, FAILMAP, checks)
     if not you.see_cell(you_x, you_y) then
       -- Draw the view to show the problem.
       crawl.redraw_view()
@@ -0,0 +1,73 @@
+-- Let groups of spellcasters and archers fight each other for a while.
+-- Monster tracers are answered from the tracer cache where possible; each
+-- cached answer is checked against a freshly fired tracer.
+
+local hostile = { "orc wizard", "deep elf sorcerer", "centaur",
+                  "kobold demonologist", "ogre mage", "orc priest" }
+local friendly = { "deep elf knight att:friendly", "orc wizard att:friendly",
+                   "centaur att:friendly", "yaktaur att:friendly" }
+
+local function open_floor(x, y)
+  return feat.has_solid_floor(x, y) and not feat.is_water(x, y)
+         and not dgn.mons_at(x, y)
+end
+
+local function place_near(cx, cy, specs)
+  for _, spec in ipairs(specs) do
+    for tries = 1, 30 do
+      local x = cx + crawl.random_range(-3, 3)
+      local y = cy + crawl.random_range(-3, 3)
+      if dgn.in_bounds(x, y) and open_floor(x, y) then
+        dgn.create_monster(x, y, "generate_awake " .. spec)
+        break
+      end
+    end
+  end
+end
+
+local function fight(rounds)
+  for round = 1, rounds do
+    for y = 1, dgn.GYM - 2 do
+      for x = 1, dgn.GXM - 2 do
+        local mons = dgn.mons_at(x, y)
+        if mons then
+          mons.add_energy(10)
+          mons.run_ai()
+        end
+      end
+    end
+  end
+end
+
+local function test_fight(depth)
+  test.regenerate_level("D:" .. depth)
+  debug.dismiss_monsters()
+
+  -- Keep the fight away from the player.
+  local px, py = you.pos()
+  local x, y
+  repeat
+    x = crawl.random_range(10, dgn.GXM - 11)
+    y = crawl.random_range(10, dgn.GYM - 11)
+  until open_floor(x, y) and math.max(math.abs(x - px), math.abs(y - py)) > 20
+  place_near(x, y, hostile)
+  place_near(x + 2, y + 2, friendly)
+
+  local before = debug.tracer_stats()
+  fight(10)
+  local after = debug.tracer_stats()
+  assert(after.monster_turns > before.monster_turns,
+         "no monster turns on D:" .. depth)
+  assert(after.cached <= after.calls, "more cached tracers than tracers")
+  assert(after.stale == before.stale,
+         (after.stale - before.stale) .. " stale cached tracers on D:" .. depth)
+  debug.dismiss_monsters()
+end
+
+debug.check_tracer_cache(true)
+local start = debug.tracer_stats()
+for depth = 3, 8 do
+  test_fight(depth)
+end
+local cached = debug.tracer_stats().cached - start.cached
+assert(cached > 0, "no tracers were answered from the cache")
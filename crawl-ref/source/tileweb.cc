@@ -72,6 +72,9 @@
 
 //#define DEBUG_WEBSOCKETS
 
+// The newest packed map cell format we can send; see _pack_cell().
+#define MAP_ENCODING_VERSION 1
+
 static unsigned int get_milliseconds()
 {
     // This is Unix-only, but so is Webtiles at the moment.
@@ -93,6 +96,8 @@ TilesFramework::TilesFramework() :
       m_next_view_tl(0, 0),
       m_next_view_br(-1, -1),
       m_need_full_map(true),
+      m_map_encoding(0),
+      m_last_map_bytes(0),
       m_text_menu("menu_txt"),
       m_print_fg(15)
 {
@@ -450,6 +455,15 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         // TODO: remove this fixup call
         c = (int) keycode->number_;
     }
+    else if (msgtype == "map_encoding")
+    {
+        // Sent by the server once every client watching can read packed
+        // map cells (or when one that can't joins).
+        JsonWrapper version = json_find_member(obj.node, "version");
+        version.check(JSON_NUMBER);
+        m_map_encoding = max(0, min((int) version->number_,
+                                    MAP_ENCODING_VERSION));
+    }
     else if (msgtype == "spectator_joined")
     {
         flush_messages();
@@ -711,7 +725,7 @@ void TilesFramework::_send_version()
 {
 #ifdef WEB_DIR_PATH
     // The star signals a message to the server
-    send_message("*{\"msg\":\"client_path\",\"path\":\"%s\",\"version\":\"%s\"}", WEB_DIR_PATH, Version::Long);
+    send_message("*{\"msg\":\"client_path\",\"path\":\"%s\",\"version\":\"%s\",\"map_encoding\":%d}", WEB_DIR_PATH, Version::Long, MAP_ENCODING_VERSION);
 #endif
 
     string title = CRAWL " " + string(Version::Long);
@@ -1523,6 +1537,233 @@ void TilesFramework::write_tileidx(tileidx_t t)
         tiles.write_message("[%d,%d]", lo, hi);
 }
 
+// Packed map cells
+//
+// Clients that announce support for it (see "map_encoding" control
+// messages) receive the scalar parts of each changed cell in a compact
+// binary form, base64 encoded into the "bin" member of the map message,
+// instead of as JSON. Monsters and dolls are still sent as JSON.
+//
+// Each cell is a varint field mask followed by the fields whose bits are
+// set, in bit order. Integers are unsigned LEB128 varints; signed ones are
+// zigzag encoded first, and tile indices are sent as their low and high
+// 32 bits. Without MAP_BIN_POS the cell follows the previous one on the
+// same row. webserver/game_data/static/map_knowledge.js decodes this;
+// keep the two in sync and bump MAP_ENCODING_VERSION on any change.
+enum map_bin_field
+{
+    MAP_BIN_POS            = 1 << 0,
+    MAP_BIN_FEAT           = 1 << 1,
+    MAP_BIN_MAP_FEAT       = 1 << 2,
+    MAP_BIN_GLYPH          = 1 << 3,
+    MAP_BIN_COLOUR         = 1 << 4,
+    MAP_BIN_FLASH_COLOUR   = 1 << 5,
+    MAP_BIN_FLASH_ALPHA    = 1 << 6,
+    MAP_BIN_FG             = 1 << 7,
+    MAP_BIN_BASE           = 1 << 8,
+    MAP_BIN_BG             = 1 << 9,
+    MAP_BIN_CLOUD          = 1 << 10,
+    MAP_BIN_ICONS          = 1 << 11,
+    MAP_BIN_FLAGS          = 1 << 12,
+    MAP_BIN_HALO           = 1 << 13,
+    MAP_BIN_ORB_GLOW       = 1 << 14,
+    MAP_BIN_BLOOD_ROTATION = 1 << 15,
+    MAP_BIN_TRAVEL_TRAIL   = 1 << 16,
+    MAP_BIN_FLAVOUR        = 1 << 17,
+    MAP_BIN_OVERLAYS       = 1 << 18,
+};
+
+// The boolean cell properties sent under MAP_BIN_FLAGS, in bit order.
+enum map_bin_flag
+{
+    MAP_FLAG_BLOODY               = 1 << 0,
+    MAP_FLAG_OLD_BLOOD            = 1 << 1,
+    MAP_FLAG_SILENCED             = 1 << 2,
+    MAP_FLAG_HIGHLIGHTED_SUMMONER = 1 << 3,
+    MAP_FLAG_SANCTUARY            = 1 << 4,
+    MAP_FLAG_BLASPHEMY            = 1 << 5,
+    MAP_FLAG_HAS_BFB_CORPSE       = 1 << 6,
+    MAP_FLAG_LIQUEFIED            = 1 << 7,
+    MAP_FLAG_QUAD_GLOW            = 1 << 8,
+    MAP_FLAG_DISJUNCT             = 1 << 9,
+    MAP_FLAG_MANGROVE_WATER       = 1 << 10,
+    MAP_FLAG_AWAKENED_FOREST      = 1 << 11,
+};
+
+static void _bin_uint(string &buf, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back((char) ((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back((char) value);
+}
+
+static void _bin_int(string &buf, int value)
+{
+    _bin_uint(buf, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+static void _bin_tileidx(string &buf, tileidx_t t)
+{
+    _bin_uint(buf, t & 0xFFFFFFFF);
+    _bin_uint(buf, t >> 32);
+}
+
+static unsigned int _cell_flags(const packed_cell &cell)
+{
+    unsigned int flags = 0;
+    if (Options.show_blood)
+    {
+        if (cell.is_bloody)
+            flags |= MAP_FLAG_BLOODY;
+        if (cell.old_blood)
+            flags |= MAP_FLAG_OLD_BLOOD;
+    }
+    if (cell.is_silenced)
+        flags |= MAP_FLAG_SILENCED;
+    if (cell.is_highlighted_summoner)
+        flags |= MAP_FLAG_HIGHLIGHTED_SUMMONER;
+    if (cell.is_sanctuary)
+        flags |= MAP_FLAG_SANCTUARY;
+    if (cell.is_blasphemy)
+        flags |= MAP_FLAG_BLASPHEMY;
+    if (cell.has_bfb_corpse)
+        flags |= MAP_FLAG_HAS_BFB_CORPSE;
+    if (cell.is_liquefied)
+        flags |= MAP_FLAG_LIQUEFIED;
+    if (cell.quad_glow)
+        flags |= MAP_FLAG_QUAD_GLOW;
+    if (cell.disjunct)
+        flags |= MAP_FLAG_DISJUNCT;
+    if (cell.mangrove_water)
+        flags |= MAP_FLAG_MANGROVE_WATER;
+    if (cell.awakened_forest)
+        flags |= MAP_FLAG_AWAKENED_FOREST;
+    return flags;
+}
+
+static string _base64(const string &data)
+{
+    static const char digits[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        const size_t left = data.size() - i;
+        uint32_t n = (uint8_t) data[i] << 16;
+        if (left > 1)
+            n |= (uint8_t) data[i + 1] << 8;
+        if (left > 2)
+            n |= (uint8_t) data[i + 2];
+        out.push_back(digits[(n >> 18) & 0x3F]);
+        out.push_back(digits[(n >> 12) & 0x3F]);
+        out.push_back(left > 1 ? digits[(n >> 6) & 0x3F] : '=');
+        out.push_back(left > 2 ? digits[n & 0x3F] : '=');
+    }
+    return out;
+}
+
+void TilesFramework::_send_cell_monster(const coord_def &gc,
+                                        const map_cell &current_mc,
+                                        const map_cell &next_mc,
+                                        map<uint32_t, coord_def>& new_monster_locs,
+                                        bool force_full)
+{
+    if (next_mc.monsterinfo())
+        _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
+    else if (current_mc.monsterinfo())
+        json_write_null("mon");
+}
+
+// Write the doll or monster cache entry for the foreground tile, if it
+// changed. Called with the cell's "t" object open.
+void TilesFramework::_send_cell_doll(const packed_cell &next_pc,
+                                     bool fg_changed)
+{
+    const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
+    const bool in_water = _in_water(next_pc);
+
+    if (fg_idx >= TILEP_MCACHE_START)
+    {
+        if (fg_changed)
+        {
+            mcache_entry *entry = mcache.get(fg_idx);
+            if (entry)
+                send_mcache(entry, in_water);
+            else
+            {
+                json_write_comma();
+                write_message("\"doll\":[[%d,%d]]", TILEP_MONS_UNKNOWN, TILE_Y);
+                json_write_null("mcache");
+            }
+        }
+    }
+    else if (fg_idx == TILEP_PLAYER)
+    {
+        bool player_doll_changed = false;
+        dolls_data result = player_doll;
+        fill_doll_equipment(result);
+        if (result != last_player_doll)
+        {
+            player_doll_changed = true;
+            last_player_doll = result;
+        }
+        if (fg_changed || player_doll_changed)
+        {
+            send_doll(last_player_doll, in_water, false);
+            if (player_uses_monster_tile())
+            {
+                monster_info minfo(MONS_PLAYER, MONS_PLAYER);
+                minfo.props[MONSTER_TILE_KEY] =
+                    int(last_player_doll.parts[TILEP_PART_BASE]);
+                item_def *item;
+                if (you.slot_item(EQ_WEAPON))
+                {
+                    item = new item_def(
+                        get_item_known_info(*you.slot_item(EQ_WEAPON)));
+                    minfo.inv[MSLOT_WEAPON].reset(item);
+                }
+                if (you.slot_item(EQ_OFFHAND))
+                {
+                    item = new item_def(
+                        get_item_known_info(*you.slot_item(EQ_OFFHAND)));
+                    minfo.inv[MSLOT_SHIELD].reset(item);
+                }
+                tileidx_t mcache_idx = mcache.register_monster(minfo);
+                mcache_entry *entry = mcache.get(mcache_idx);
+                if (entry)
+                    send_mcache(entry, in_water, false);
+                else
+                    json_write_null("mcache");
+            }
+            else
+                json_write_null("mcache");
+        }
+    }
+    else if (get_tile_texture(fg_idx) == TEX_PLAYER)
+    {
+        if (fg_changed)
+        {
+            json_write_comma();
+            write_message("\"doll\":[[%u,%d]]", (unsigned int) fg_idx, TILE_Y);
+            json_write_null("mcache");
+        }
+    }
+    else
+    {
+        if (fg_changed)
+        {
+            json_write_comma();
+            json_write_null("doll");
+            json_write_null("mcache");
+        }
+    }
+}
+
 void TilesFramework::_send_cell(const coord_def &gc,
                                 const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                                 const map_cell &current_mc, const map_cell &next_mc,
@@ -1532,10 +1773,7 @@ void TilesFramework::_send_cell(const coord_def &gc,
     if (current_mc.feat() != next_mc.feat())
         json_write_int("f", next_mc.feat());
 
-    if (next_mc.monsterinfo())
-        _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
-    else if (current_mc.monsterinfo())
-        json_write_null("mon");
+    _send_cell_monster(gc, current_mc, next_mc, new_monster_locs, force_full);
 
     map_feature mf = get_cell_map_feature(gc);
     if (get_cell_map_feature(current_mc) != mf)
@@ -1568,8 +1806,6 @@ void TilesFramework::_send_cell(const coord_def &gc,
         const packed_cell &current_pc = current_sc.tile;
 
         const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
-
-        const bool in_water = _in_water(next_pc);
         bool fg_changed = false;
 
         if (next_pc.fg != current_pc.fg)
@@ -1663,81 +1899,7 @@ void TilesFramework::_send_cell(const coord_def &gc,
             json_close_object();
         }
 
-        if (fg_idx >= TILEP_MCACHE_START)
-        {
-            if (fg_changed)
-            {
-                mcache_entry *entry = mcache.get(fg_idx);
-                if (entry)
-                    send_mcache(entry, in_water);
-                else
-                {
-                    json_write_comma();
-                    write_message("\"doll\":[[%d,%d]]", TILEP_MONS_UNKNOWN, TILE_Y);
-                    json_write_null("mcache");
-                }
-            }
-        }
-        else if (fg_idx == TILEP_PLAYER)
-        {
-            bool player_doll_changed = false;
-            dolls_data result = player_doll;
-            fill_doll_equipment(result);
-            if (result != last_player_doll)
-            {
-                player_doll_changed = true;
-                last_player_doll = result;
-            }
-            if (fg_changed || player_doll_changed)
-            {
-                send_doll(last_player_doll, in_water, false);
-                if (player_uses_monster_tile())
-                {
-                    monster_info minfo(MONS_PLAYER, MONS_PLAYER);
-                    minfo.props[MONSTER_TILE_KEY] =
-                        int(last_player_doll.parts[TILEP_PART_BASE]);
-                    item_def *item;
-                    if (you.slot_item(EQ_WEAPON))
-                    {
-                        item = new item_def(
-                            get_item_known_info(*you.slot_item(EQ_WEAPON)));
-                        minfo.inv[MSLOT_WEAPON].reset(item);
-                    }
-                    if (you.slot_item(EQ_OFFHAND))
-                    {
-                        item = new item_def(
-                            get_item_known_info(*you.slot_item(EQ_OFFHAND)));
-                        minfo.inv[MSLOT_SHIELD].reset(item);
-                    }
-                    tileidx_t mcache_idx = mcache.register_monster(minfo);
-                    mcache_entry *entry = mcache.get(mcache_idx);
-                    if (entry)
-                        send_mcache(entry, in_water, false);
-                    else
-                        json_write_null("mcache");
-                }
-                else
-                    json_write_null("mcache");
-            }
-        }
-        else if (get_tile_texture(fg_idx) == TEX_PLAYER)
-        {
-            if (fg_changed)
-            {
-                json_write_comma();
-                write_message("\"doll\":[[%u,%d]]", (unsigned int) fg_idx, TILE_Y);
-                json_write_null("mcache");
-            }
-        }
-        else
-        {
-            if (fg_changed)
-            {
-                json_write_comma();
-                json_write_null("doll");
-                json_write_null("mcache");
-            }
-        }
+        _send_cell_doll(next_pc, fg_changed);
 
         bool overlays_changed = false;
 
@@ -1766,6 +1928,146 @@ void TilesFramework::_send_cell(const coord_def &gc,
     json_close_object(true);
 }
 
+// Append the packed form of a cell's scalar fields to m_cell_bin. Mirrors
+// the JSON written by _send_cell; returns false without writing anything
+// if none of them changed.
+bool TilesFramework::_pack_cell(const coord_def &gc, bool send_pos,
+                                const screen_cell_t &current_sc,
+                                const screen_cell_t &next_sc,
+                                const map_cell &current_mc,
+                                const map_cell &next_mc,
+                                bool force_full)
+{
+    const packed_cell &next_pc = next_sc.tile;
+    const packed_cell &current_pc = current_sc.tile;
+    const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
+    const map_feature mf = get_cell_map_feature(gc);
+    const unsigned int flags = _cell_flags(next_pc);
+    const unsigned int changed_flags = flags ^ _cell_flags(current_pc);
+
+    bool overlays_changed =
+        next_pc.num_dngn_overlay != current_pc.num_dngn_overlay;
+    for (int i = 0; !overlays_changed && i < next_pc.num_dngn_overlay; i++)
+        if (next_pc.dngn_overlay[i] != current_pc.dngn_overlay[i])
+            overlays_changed = true;
+
+    uint32_t mask = 0;
+    if (current_mc.feat() != next_mc.feat())
+        mask |= MAP_BIN_FEAT;
+    if (get_cell_map_feature(current_mc) != mf)
+        mask |= MAP_BIN_MAP_FEAT;
+    if (current_sc.glyph != next_sc.glyph)
+        mask |= MAP_BIN_GLYPH;
+    if ((current_sc.colour != next_sc.colour || current_sc.glyph == ' ')
+        && next_sc.glyph != ' ')
+    {
+        mask |= MAP_BIN_COLOUR;
+    }
+    if (current_sc.flash_colour != next_sc.flash_colour)
+        mask |= MAP_BIN_FLASH_COLOUR;
+    if (current_sc.flash_alpha != next_sc.flash_alpha)
+        mask |= MAP_BIN_FLASH_ALPHA;
+    if (next_pc.fg != current_pc.fg)
+    {
+        mask |= MAP_BIN_FG;
+        if (get_tile_texture(fg_idx) == TEX_DEFAULT)
+            mask |= MAP_BIN_BASE;
+    }
+    if (next_pc.bg != current_pc.bg)
+        mask |= MAP_BIN_BG;
+    if (next_pc.cloud != current_pc.cloud)
+        mask |= MAP_BIN_CLOUD;
+    if (next_pc.icons != current_pc.icons)
+        mask |= MAP_BIN_ICONS;
+    if (changed_flags)
+        mask |= MAP_BIN_FLAGS;
+    if (next_pc.halo != current_pc.halo)
+        mask |= MAP_BIN_HALO;
+    if (next_pc.orb_glow != current_pc.orb_glow)
+        mask |= MAP_BIN_ORB_GLOW;
+    if (next_pc.blood_rotation != current_pc.blood_rotation)
+        mask |= MAP_BIN_BLOOD_ROTATION;
+    if (next_pc.travel_trail != current_pc.travel_trail)
+        mask |= MAP_BIN_TRAVEL_TRAIL;
+    if (_needs_flavour(next_pc)
+        && (next_pc.flv.floor != current_pc.flv.floor
+            || next_pc.flv.special != current_pc.flv.special
+            || !_needs_flavour(current_pc)
+            || force_full))
+    {
+        mask |= MAP_BIN_FLAVOUR;
+    }
+    if (overlays_changed)
+        mask |= MAP_BIN_OVERLAYS;
+
+    if (!mask)
+        return false;
+    if (send_pos)
+        mask |= MAP_BIN_POS;
+
+    string &buf = m_cell_bin;
+    _bin_uint(buf, mask);
+    if (mask & MAP_BIN_POS)
+    {
+        _bin_int(buf, gc.x - m_origin.x);
+        _bin_int(buf, gc.y - m_origin.y);
+    }
+    if (mask & MAP_BIN_FEAT)
+        _bin_uint(buf, next_mc.feat());
+    if (mask & MAP_BIN_MAP_FEAT)
+        _bin_uint(buf, mf);
+    if (mask & MAP_BIN_GLYPH)
+        _bin_uint(buf, next_sc.glyph);
+    if (mask & MAP_BIN_COLOUR)
+    {
+        const int col = next_sc.colour;
+        _bin_uint(buf, (_get_highlight(col) << 4) | macro_colour(col & 0xF));
+    }
+    if (mask & MAP_BIN_FLASH_COLOUR)
+        _bin_uint(buf, next_sc.flash_colour);
+    if (mask & MAP_BIN_FLASH_ALPHA)
+        _bin_uint(buf, next_sc.flash_alpha);
+    if (mask & MAP_BIN_FG)
+        _bin_tileidx(buf, next_pc.fg);
+    if (mask & MAP_BIN_BASE)
+        _bin_uint(buf, tileidx_known_base_item(fg_idx));
+    if (mask & MAP_BIN_BG)
+        _bin_tileidx(buf, next_pc.bg);
+    if (mask & MAP_BIN_CLOUD)
+        _bin_tileidx(buf, next_pc.cloud);
+    if (mask & MAP_BIN_ICONS)
+    {
+        _bin_uint(buf, next_pc.icons.size());
+        for (const tileidx_t icon : next_pc.icons)
+            _bin_tileidx(buf, icon);
+    }
+    if (mask & MAP_BIN_FLAGS)
+    {
+        _bin_uint(buf, changed_flags);
+        _bin_uint(buf, flags & changed_flags);
+    }
+    if (mask & MAP_BIN_HALO)
+        _bin_int(buf, next_pc.halo);
+    if (mask & MAP_BIN_ORB_GLOW)
+        _bin_uint(buf, next_pc.orb_glow);
+    if (mask & MAP_BIN_BLOOD_ROTATION)
+        _bin_int(buf, next_pc.blood_rotation);
+    if (mask & MAP_BIN_TRAVEL_TRAIL)
+        _bin_uint(buf, next_pc.travel_trail);
+    if (mask & MAP_BIN_FLAVOUR)
+    {
+        _bin_uint(buf, next_pc.flv.floor);
+        _bin_uint(buf, next_pc.flv.special);
+    }
+    if (mask & MAP_BIN_OVERLAYS)
+    {
+        _bin_uint(buf, next_pc.num_dngn_overlay);
+        for (int i = 0; i < next_pc.num_dngn_overlay; ++i)
+            _bin_int(buf, next_pc.dngn_overlay[i]);
+    }
+    return true;
+}
+
 void TilesFramework::_send_cursor(cursor_type type)
 {
     if (m_cursor[type] == NO_CURSOR)
@@ -1850,6 +2152,13 @@ void TilesFramework::_send_map(bool force_full)
     coord_def last_gc(0, 0);
     bool send_gc = true;
 
+    // With a packed map encoding, the JSON cells only carry monsters and
+    // dolls, so they always give their position.
+    const bool packed = m_map_encoding > 0;
+    coord_def last_bin_gc(0, 0);
+    bool send_bin_gc = true;
+    m_cell_bin.clear();
+
     int flash_colour = you.flash_colour;
     if (flash_colour == BLACK)
         flash_colour = viewmap_flash_colour();
@@ -1881,7 +2190,8 @@ void TilesFramework::_send_map(bool force_full)
                 m_origin = gc;
 
             json_open_object();
-            if (send_gc
+            if (packed
+                || send_gc
                 || last_gc.x + 1 != gc.x
                 || last_gc.y != gc.y)
             {
@@ -1894,11 +2204,34 @@ void TilesFramework::_send_map(bool force_full)
                 : m_current_view(gc);
             const map_cell& mc = force_full ? default_map_cell
                 : m_current_map_knowledge(gc);
-            _send_cell(gc,
-                       sc,
-                       m_next_view(gc),
-                       mc, env.map_knowledge(gc),
-                       new_monster_locs, force_full);
+            if (packed)
+            {
+                const bool send_pos = send_bin_gc
+                                      || last_bin_gc.x + 1 != gc.x
+                                      || last_bin_gc.y != gc.y;
+                if (_pack_cell(gc, send_pos, sc, m_next_view(gc),
+                               mc, env.map_knowledge(gc), force_full))
+                {
+                    send_bin_gc = false;
+                    last_bin_gc = gc;
+                }
+
+                _send_cell_monster(gc, mc, env.map_knowledge(gc),
+                                   new_monster_locs, force_full);
+                json_open_object("t");
+                json_treat_as_empty();
+                _send_cell_doll(m_next_view(gc).tile,
+                                m_next_view(gc).tile.fg != sc.tile.fg);
+                json_close_object(true);
+            }
+            else
+            {
+                _send_cell(gc,
+                           sc,
+                           m_next_view(gc),
+                           mc, env.map_knowledge(gc),
+                           new_monster_locs, force_full);
+            }
 
             if (!json_is_empty())
             {
@@ -1909,8 +2242,12 @@ void TilesFramework::_send_map(bool force_full)
         }
     json_close_array(true);
 
+    if (!m_cell_bin.empty())
+        json_write_string("bin", _base64(m_cell_bin));
+
     json_close_object(true);
 
+    m_last_map_bytes = m_msg_buf.size();
     finish_message();
 
     if (force_full)
@@ -2216,6 +2553,17 @@ void TilesFramework::redraw()
     m_last_tick_redraw = get_milliseconds();
 }
 
+int TilesFramework::bench_map(int encoding, bool force_full)
+{
+    unwind_var<int> enc(m_map_encoding,
+                        max(0, min(encoding, MAP_ENCODING_VERSION)));
+    m_last_map_bytes = 0;
+    if (m_view_loaded)
+        _send_map(force_full);
+    m_need_redraw = false;
+    return m_last_map_bytes;
+}
+
 void TilesFramework::update_minimap(const coord_def& gc)
 {
     if (gc.x < 0 || gc.x >= GXM || gc.y < 0 || gc.y >= GYM)
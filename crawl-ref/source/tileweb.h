@@ -222,6 +222,10 @@ public:
     void send_milestone(const xlog_fields &xl);
     void send_options();
 
+    // Build the map update redraw() would send, even without receivers,
+    // using the given map encoding. Returns the size of the message.
+    int bench_map(int encoding, bool force_full = false);
+
 protected:
     int m_sock;
     int m_max_msg_size;
@@ -290,6 +294,11 @@ protected:
     map<uint32_t, coord_def> m_monster_locs;
     bool m_need_full_map;
 
+    // Packed map cell format understood by every receiver; 0 for JSON.
+    int m_map_encoding;
+    string m_cell_bin;
+    int m_last_map_bytes;
+
     coord_def m_cursor[CURSOR_MAX];
     coord_def m_last_clicked_grid;
     bool m_text_cursor;
@@ -324,6 +333,17 @@ protected:
                     const map_cell &current_mc, const map_cell &next_mc,
                     map<uint32_t, coord_def>& new_monster_locs,
                     bool force_full);
+    void _send_cell_monster(const coord_def &gc,
+                            const map_cell &current_mc,
+                            const map_cell &next_mc,
+                            map<uint32_t, coord_def>& new_monster_locs,
+                            bool force_full);
+    void _send_cell_doll(const packed_cell &next_pc, bool fg_changed);
+    bool _pack_cell(const coord_def &gc, bool send_pos,
+                    const screen_cell_t &current_sc,
+                    const screen_cell_t &next_sc,
+                    const map_cell &current_mc, const map_cell &next_mc,
+                    bool force_full);
     void _send_monster(const coord_def &gc, const monster_info* m,
                        map<uint32_t, coord_def>& new_monster_locs,
                        bool force_full);
@@ -16,6 +16,7 @@
 #include <cstdarg>
 #include <cstdio>
 #include <memory>
+#include <queue>
 #include <set>
 #include <sstream>
 
@@ -91,10 +92,6 @@ enum IntertravelDestination
 
 TravelCache travel_cache;
 
-// Tracks the distance between the target location on the target level and the
-// stairs on the level.
-static vector<stair_info> curr_stairs;
-
 // Squares that are not safe to travel to on the current level.
 exclude_set curr_excludes;
 
@@ -194,8 +191,7 @@ static deviant_route_warning _Route_Warning;
 static bool _find_transtravel_square(const level_pos &pos,
                                      bool verbose = true);
 
-static bool _loadlev_populate_stair_distances(const level_pos &target);
-static void _populate_stair_distances(const level_pos &target);
+static void _stair_graph_changed();
 static bool _is_greed_inducing_square(const LevelStashes *ls,
                                       const coord_def &c, bool autopickup);
 
@@ -2875,19 +2871,18 @@ void start_translevel_travel(const level_pos &pos)
 
     level_target = pos;
 
-    // Check that it's level + position, not just level.
-    if (pos.is_valid())
+    // How far the target is from its level's stairs isn't saved; if that
+    // level hasn't been seen since the game was loaded, look at it again.
+    if (pos.is_valid() && pos.id != level_id::current()
+        && is_existing_level(pos.id))
     {
-        if (pos.id != level_id::current())
+        LevelInfo &li = travel_cache.get_level_info(pos.id);
+        if (!li.has_stair_fields())
         {
-            if (!_loadlev_populate_stair_distances(pos))
-            {
-                mpr("Level memory is imperfect, aborting.");
-                return ;
-            }
+            level_excursion excursion;
+            excursion.go_to(pos.id);
+            li.update_stair_fields();
         }
-        else
-            _populate_stair_distances(pos);
     }
 
     trans_travel_dest = _get_trans_travel_dest(level_target);
@@ -2920,20 +2915,228 @@ static void _start_translevel_travel_prompt()
     start_translevel_travel(target);
 }
 
-static int _target_distance_from(const coord_def &pos)
+/////////////////////////////////////////////////////////////////////////////
+// Interlevel stair graph
+//
+// Every stair in the travel cache is a node. Standing on a stair, travel can
+// walk to another usable stair on the same level, at the distance
+// LevelInfo::update_stair_distances() found, or take the stair and arrive on
+// the stair at its destination. The shortest distances from a stair to every
+// other stair are kept until any level's stairs change, so interlevel travel
+// only looks at the stairs it can reach on the current level and the stairs
+// into the target level. Another level is only loaded to find a target
+// position there when the game was loaded after the level was last seen.
+
+// The cost of taking a staircase.
+static const int STAIR_COST = 500; // XXX: this seems large?
+
+struct stair_node
+{
+    level_id level;
+    int index;      // Into the level's stairs.
+    bool usable;    // Can travel walk to this stair and take it?
+    int arrival;    // The node for the stair it leads to, or -1.
+};
+
+struct stair_graph
 {
-    for (const stair_info &stair : curr_stairs)
-        if (stair.position == pos)
-            return stair.distance;
+    bool dirty = true;
+    level_id built_on;
+    vector<stair_node> nodes;
+    map<level_id, int> first_node;
+    // rows[h][n], when filled in, holds the shortest distances from standing
+    // on stair n to standing on every other stair. Stairs into the hells are
+    // only taken from outside them if h is set.
+    vector<vector<int>> rows[2];
+};
 
-    return -1;
+static stair_graph _stair_graph;
+
+static void _stair_graph_changed()
+{
+    _stair_graph.dirty = true;
+}
+
+static const stair_info &_node_stair(const stair_node &node)
+{
+    return travel_cache.get_level_info(node.level).get_stairs()[node.index];
+}
+
+// The node for the stair at pos on lev, or -1 if we don't know of one.
+static int _find_stair_node(const level_id &lev, const coord_def &pos)
+{
+    const int *first = map_find(_stair_graph.first_node, lev);
+    LevelInfo *li = travel_cache.find_level_info(lev);
+    if (!first || !li)
+        return -1;
+
+    const int index = li->get_stair_index(pos);
+    return index == -1 ? -1 : *first + index;
+}
+
+static void _build_stair_graph()
+{
+    stair_graph &graph = _stair_graph;
+    graph.nodes.clear();
+    graph.first_node.clear();
+
+    for (const level_id &lev : travel_cache.known_levels())
+    {
+        LevelInfo &li = travel_cache.get_level_info(lev);
+        const vector<stair_info> &stairs = li.get_stairs();
+
+        graph.first_node[lev] = graph.nodes.size();
+        for (int i = 0; i < (int) stairs.size(); ++i)
+        {
+            const stair_info &si = stairs[i];
+            stair_node node;
+            node.level = lev;
+            node.index = i;
+            // Skip placeholders and excluded stairs.
+            node.usable = si.can_travel()
+                          && !is_excluded(si.position, li.get_excludes())
+                          && !stairs_destination_is_excluded(si);
+            node.arrival = -1;
+            graph.nodes.push_back(node);
+        }
+    }
+
+    for (stair_node &node : graph.nodes)
+    {
+        const level_pos &dest = _node_stair(node).destination;
+        if (dest.is_valid())
+            node.arrival = _find_stair_node(dest.id, dest.pos);
+    }
+
+    for (vector<vector<int>> &rows : graph.rows)
+        rows.assign(graph.nodes.size(), vector<int>());
+    graph.built_on = level_id::current();
+    graph.dirty = false;
+}
+
+// Don't try hell branches if we are not already in one or targeting one.
+// When you actually enter the vestibule, the branch entry point is adjusted
+// to be the portal you entered through, but autotravel needs to simulate
+// this somehow, or it can find (fake) paths through hell that are shortcuts
+// in depths, because the vestibule side of the portals do map to particular
+// portals scattered throughout depths, even if those mappings won't be used
+// while exiting from the vestibule.
+static bool _may_take_stair(const stair_node &node, bool hell_target)
+{
+    const level_id &dest = _node_stair(node).destination.id;
+    return hell_target || !is_hell_branch(dest.branch)
+           || is_hell_branch(node.level.branch);
+}
+
+// The shortest distances from standing on stair "from" to standing on every
+// other stair, or INT_MAX where there is no route.
+static const vector<int> &_stair_graph_row(int from, bool hell_target)
+{
+    const vector<stair_node> &nodes = _stair_graph.nodes;
+    vector<int> &row = _stair_graph.rows[hell_target][from];
+    if (!row.empty())
+        return row;
+
+    typedef pair<int, int> node_distance;
+    priority_queue<node_distance, vector<node_distance>,
+                   greater<node_distance>> queue;
+    row.assign(nodes.size(), INT_MAX);
+    row[from] = 0;
+    queue.emplace(0, from);
+
+    while (!queue.empty())
+    {
+        const int dist = queue.top().first;
+        const int n = queue.top().second;
+        queue.pop();
+        if (dist > row[n])
+            continue;
+
+        auto relax = [&](int to, int cost)
+        {
+            if (dist + cost < row[to])
+            {
+                row[to] = dist + cost;
+                queue.emplace(row[to], to);
+            }
+        };
+
+        const stair_node &node = nodes[n];
+        LevelInfo &li = travel_cache.get_level_info(node.level);
+        const vector<stair_info> &stairs = li.get_stairs();
+        const int first = n - node.index;
+        for (int i = 0; i < (int) stairs.size(); ++i)
+        {
+            if (i == node.index || !nodes[first + i].usable)
+                continue;
+
+            // If two stairs are disconnected, the distance is negative.
+            const int deltadist = li.distance_between(&stairs[node.index],
+                                                      &stairs[i]);
+            if (deltadist >= 0)
+                relax(first + i, deltadist);
+        }
+
+        if (node.usable && node.arrival != -1
+            && _may_take_stair(node, hell_target))
+        {
+            relax(node.arrival, STAIR_COST);
+        }
+    }
+    return row;
+}
+
+// How far is target from standing on a stair, if the way there starts by
+// taking that stair and doesn't take any other? Returns -1 if it doesn't.
+static int _stair_to_target(const stair_node &node, const level_pos &target,
+                            bool hell_target)
+{
+    if (!node.usable)
+        return -1;
+
+    const stair_info &si = _node_stair(node);
+    const level_pos &dest = si.destination;
+    if (dest.id != target.id)
+        return -1;
+
+    // With no exact target location, any way onto the target level will
+    // do, except that escape hatches are never used as the last leg of the
+    // trip, since that will leave the player unable to retrace their path.
+    if (target.pos.x == -1)
+        return feat_is_escape_hatch(si.grid) ? -1 : STAIR_COST;
+
+    if (node.arrival == -1 || !_may_take_stair(node, hell_target))
+        return -1;
+
+    // Don't arrive in an exclude, unless it is just a stair exclusion.
+    LevelInfo &li = travel_cache.get_level_info(target.id);
+    const exclude_set &excludes = li.get_excludes();
+    if (is_excluded(dest.pos, excludes))
+    {
+        auto ex = excludes.begin();
+        while (ex != excludes.end() && ex->first != dest.pos)
+            ++ex;
+        if (ex == excludes.end() || ex->second.radius != 1)
+            return -1;
+    }
+
+    // start_translevel_travel() made sure these distances are known; if they
+    // still aren't, don't guess.
+    const int deltadist = li.distance_from_stair(
+        _node_stair(_stair_graph.nodes[node.arrival]), target.pos);
+    if (deltadist < 0)
+        return -1;
+
+    return STAIR_COST + deltadist;
 }
 
 /*
- * Sets best_stair to the coordinates of the best stair on the player's current
- * level to take to get to the 'target' level. Should be called with 'distance'
- * set to 0, 'stair' set to (you.x_pos, you.y_pos) and 'best_distance' set to
- * -1. 'cur' should be the player's current level.
+ * Sets best_stair to the coordinates of the best stair on the player's
+ * current level to take to get to the 'target' level, or to the target
+ * itself if it's best reached without leaving the level, and returns the
+ * length of the route. If there is no route, returns -1 and sets
+ * closest_level and best_level_distance to the level nearest the target
+ * that travel does know the way to.
  *
  * If best_stair remains unchanged when this function returns, there is no
  * travel-safe path between the player's current level and the target level OR
@@ -2946,247 +3149,98 @@ static int _target_distance_from(const coord_def &pos)
  * This function has undefined behaviour when the target position is not
  * traversable.
  */
-static int _find_transtravel_stair(const level_id &cur,
-                                    const level_pos &target,
-                                    int distance,
-                                    // This is actually the current position
-                                    // on cur, not necessarily a stair.
-                                    const coord_def &stair,
-                                    level_id &closest_level,
-                                    int &best_level_distance,
-                                    coord_def &best_stair,
-                                    int search_depth = 0)
+static int _find_transtravel_stair(const level_pos &target,
+                                   level_id &closest_level,
+                                   int &best_level_distance,
+                                   coord_def &best_stair)
 {
-    int local_distance = -1;
-    level_id player_level = level_id::current();
-
+    const level_id cur = level_id::current();
     LevelInfo &li = travel_cache.get_level_info(cur);
+    int local_distance = -1;
 
     // Have we reached the target level?
     if (cur == target.id)
     {
-        // Are we in an exclude? If so, bail out. Unless it is just a stair exclusion.
-        if (is_excluded(stair, li.get_excludes()) && !is_stair_exclusion(stair))
+        // Are we in an exclude? If so, bail out. Unless it is just a stair
+        // exclusion.
+        if (is_excluded(you.pos(), li.get_excludes())
+            && !is_stair_exclusion(you.pos()))
+        {
             return -1;
+        }
 
         // If there's no target position on the target level, or we're on the
         // target, we're home.
-        if (target.pos.x == -1 || target.pos == stair)
-            return distance;
-
-        // If there *is* a target position, we need to work out our distance
-        // from it.
-        int deltadist = _target_distance_from(stair);
-
-        if (deltadist == -1 && cur == player_level)
+        if (target.pos.x == -1 || target.pos == you.pos())
+            return 0;
+
+        // A degenerate case of interlevel travel decays to normal travel.
+        // Note that even if this *is* degenerate, interlevel travel may
+        // still be able to find a shorter route, since it can consider
+        // routes that leave and reenter the current level.
+        const int deltadist = travel_point_distance[target.pos.x][target.pos.y];
+        if (deltadist > 0)
         {
-            // Okay, we don't seem to have a distance available to us, which
-            // means we're either (a) not standing on stairs or (b) whoever
-            // initiated interlevel travel didn't call
-            // _populate_stair_distances. Assuming we're not on stairs, that
-            // situation can arise only if interlevel travel has been triggered
-            // for a location on the same level. If that's the case, we can get
-            // the distance off the travel_point_distance matrix.
-            deltadist = travel_point_distance[target.pos.x][target.pos.y];
-            if (!deltadist && stair != target.pos)
-                deltadist = -1;
-        }
-
-        if (deltadist != -1)
-        {
-            local_distance = distance + deltadist;
-
-            // See if this is a degenerate case of interlevel travel:
-            // A degenerate case of interlevel travel decays to normal travel;
-            // we identify this by checking if:
-            // a. The current level is the target level.
-            // b. The target square is reachable from the 'current' square.
-            // c. The current square is where the player is.
-            //
-            // Note that even if this *is* degenerate, interlevel travel may
-            // still be able to find a shorter route, since it can consider
-            // routes that leave and reenter the current level.
-            if (player_level == target.id && stair == you.pos())
-                best_stair = target.pos;
-
-            // The local_distance is already set, but there may actually be
-            // stairs we can take that'll get us to the target faster than the
-            // direct route, so we also try the stairs.
+            local_distance = deltadist;
+            best_stair = target.pos;
         }
     }
 
-    vector<stair_info> &stairs = li.get_stairs();
-
-    // this_stair being nullptr is perfectly acceptable, since we start with
-    // coords as the player coords, and the player need not be standing on
-    // stairs.
-    stair_info *this_stair = li.get_stair(stair);
+    if (_stair_graph.dirty || _stair_graph.built_on != cur)
+        _build_stair_graph();
 
-    if (!this_stair && cur != player_level)
+    const vector<stair_node> &nodes = _stair_graph.nodes;
+    const bool hell_target = is_hell_branch(target.id.branch);
+    const int *first = map_find(_stair_graph.first_node, cur);
+    for (int s = first ? *first : nodes.size();
+         s < (int) nodes.size() && nodes[s].level == cur; ++s)
     {
-        // Whoops, there's no stair in the travel cache for the current
-        // position, and we're not on the player's current level (i.e., there
-        // certainly *should* be a stair here). Since we can't proceed in any
-        // reasonable way, bail out.
-        return local_distance;
-    }
-
-    for (stair_info &si : stairs)
-    {
-        if (stairs_destination_is_excluded(si))
-            continue;
-
-        // Skip placeholders and excluded stairs.
-        if (!si.can_travel() || is_excluded(si.position, li.get_excludes()))
-            continue;
-
-        int deltadist = li.distance_between(this_stair, &si);
-
-        if (!this_stair)
+        const coord_def stair = _node_stair(nodes[s]).position;
+        // deltadist == 0 is legal, since the player may be standing on the
+        // stairs.
+        const int deltadist = travel_point_distance[stair.x][stair.y];
+        if (!nodes[s].usable || deltadist < 0
+            || !deltadist && you.pos() != stair)
         {
-            deltadist = travel_point_distance[si.position.x][si.position.y];
-            if (!deltadist && you.pos() != si.position)
-                deltadist = -1;
-        }
-        // deltadist == 0 is legal (if this_stair is nullptr), since the player
-        // may be standing on the stairs. If two stairs are disconnected,
-        // deltadist has to be negative.
-        if (deltadist < 0)
             continue;
+        }
 
-        int dist2stair = distance + deltadist;
-        if (si.distance == -1 || si.distance > dist2stair)
+        const vector<int> &row = _stair_graph_row(s, hell_target);
+        for (int n = 0; n < (int) nodes.size(); ++n)
         {
-            si.distance = dist2stair;
-
-            // Account for the cost of taking the stairs
-            dist2stair += 500; // XXX: this seems large?
-
-            // Already too expensive? Short-circuit.
-            if (local_distance != -1 && dist2stair >= local_distance)
-                continue;
-
-            const level_pos &dest = si.destination;
-
-            // Never use escape hatches as the last leg of the trip, since
-            // that will leave the player unable to retrace their path.
-            // This does not apply if we have a destination with a specific
-            // position on the target level travel wants to get to.
-            if (feat_is_escape_hatch(si.grid)
-                && target.pos.x == -1
-                && dest.id == target.id)
-            {
+            if (row[n] == INT_MAX)
                 continue;
-            }
 
-            // We can only short-circuit the stair-following process if we
-            // have no exact target location. If there *is* an exact target
-            // location, we can't follow stairs for which we have incomplete
-            // information.
-            if (target.pos.x == -1
-                && dest.id == target.id)
+            const int togo = _stair_to_target(nodes[n], target, hell_target);
+            const int dist = deltadist + row[n] + togo;
+            if (togo != -1
+                && (local_distance == -1 || dist < local_distance))
             {
-                if (local_distance == -1 || local_distance > dist2stair)
-                {
-                    local_distance = dist2stair;
-                    if (cur == player_level && you.pos() == stair)
-                        best_stair = si.position;
-                }
-                continue;
+                local_distance = dist;
+                best_stair = stair;
             }
 
-            if (dest.id.depth > -1) // We have a valid level descriptor.
+            const level_id &dest = _node_stair(nodes[n]).destination.id;
+            if (nodes[n].usable && dest.depth > -1) // A valid level descriptor.
             {
-                int dist = level_distance(dest.id, target.id);
-                if (dist != -1 && (dist < best_level_distance
-                                   || best_level_distance == -1))
+                const int ldist = level_distance(dest, target.id);
+                if (ldist != -1 && (ldist < best_level_distance
+                                    || best_level_distance == -1))
                 {
-                    best_level_distance = dist;
-                    closest_level       = dest.id;
+                    best_level_distance = ldist;
+                    closest_level       = dest;
                 }
             }
+        }
+    }
 
-            // If we don't know where these stairs go, we can't take them.
-            if (!dest.is_valid())
-                continue;
-
-            // Don't try hell branches if we are not already in one or targeting
-            // one. When you actually enter the vestibule, the branch entry
-            // point is adjusted to be the portal you entered through, but
-            // autotravel needs to simulate this somehow, or it can find (fake)
-            // paths through hell that are shortcuts in depths, because the
-            // vestibule side of the portals do map to particular portals
-            // scattered throughout depths, even if those mappings won't be
-            // used while exiting from the vestibule.
-            if (is_hell_branch(dest.id.branch)
-                            && !(is_hell_branch(target.id.branch)
-                                 || is_hell_branch(cur.branch)))
-            {
-                continue;
-            }
-
-            // We need to get the stairs at the new location and set the
-            // distance on them as well.
-            LevelInfo &lo = travel_cache.get_level_info(dest.id);
-            if (stair_info *so = lo.get_stair(dest.pos))
-            {
-                if (so->distance == -1 || so->distance > dist2stair)
-                    so->distance = dist2stair;
-                else
-                    continue;   // We've already been here.
-            }
 #ifdef DEBUG_TRAVEL
-            string indent(search_depth, '.');
-            dprf("%strying stairs at %d,%d, dest is %d depth %d, pos %d,%d",
-                indent.c_str(), si.position.x, si.position.y, dest.id.branch,
-                dest.id.depth, dest.pos.x, dest.pos.y);
+    dprf("stair graph: %d stairs, route %d via %d,%d",
+         (int) nodes.size(), local_distance, best_stair.x, best_stair.y);
 #endif
-
-            // Okay, take these stairs and keep going.
-            const int newdist =
-                _find_transtravel_stair(dest.id, target,
-                                        dist2stair, dest.pos, closest_level,
-                                        best_level_distance, best_stair,
-                                        search_depth + 1);
-            if (newdist != -1
-                && (local_distance == -1 || local_distance > newdist))
-            {
-                local_distance = newdist;
-                if (cur == player_level && you.pos() == stair)
-                    best_stair = si.position;
-            }
-        }
-    }
     return local_distance;
 }
 
-static bool _loadlev_populate_stair_distances(const level_pos &target)
-{
-    level_excursion excursion;
-    excursion.go_to(target.id);
-    _populate_stair_distances(target);
-    return true;
-}
-
-static void _populate_stair_distances(const level_pos &target)
-{
-    // Populate travel_point_distance.
-    fill_travel_point_distance(target.pos);
-
-    curr_stairs.clear();
-    for (stair_info si : travel_cache.get_level_info(target.id).get_stairs())
-    {
-        si.distance = travel_point_distance[si.position.x][si.position.y];
-        if (!si.distance && target.pos != si.position
-            || si.distance < -1)
-        {
-            si.distance = -1;
-        }
-
-        curr_stairs.push_back(si);
-    }
-}
-
 static coord_def _find_closest_adj(coord_def targ)
 {
     coord_def closest_pos = coord_def(0,0);
@@ -3208,11 +3262,9 @@ static bool _find_transtravel_square(const level_pos &target, bool verbose)
     level_id current = level_id::current();
 
     coord_def best_stair(-1, -1);
-    coord_def cur_stair(you.pos());
 
     level_id closest_level;
     int best_level_distance = -1;
-    travel_cache.clear_distances();
 
     fill_travel_point_distance(you.pos());
 
@@ -3225,9 +3277,8 @@ static bool _find_transtravel_square(const level_pos &target, bool verbose)
 
     if (maybe_traversable)
     {
-        _find_transtravel_stair(current, target,
-                                0, cur_stair, closest_level,
-                                best_level_distance, best_stair);
+        _find_transtravel_stair(target, closest_level, best_level_distance,
+                                best_stair);
         dprf("found stair at %d,%d", best_stair.x, best_stair.y);
     }
     // even without _find_transtravel_stair called, the values are initialized
@@ -3569,10 +3620,30 @@ bool LevelInfo::empty() const
 void LevelInfo::update_excludes()
 {
     excludes = curr_excludes;
+    _stair_graph_changed();
+}
+
+static bool _same_stairs(const vector<stair_info> &a,
+                         const vector<stair_info> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (unsigned int i = 0; i < a.size(); ++i)
+    {
+        if (a[i].position != b[i].position || a[i].grid != b[i].grid
+            || a[i].destination != b[i].destination || a[i].type != b[i].type)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 void LevelInfo::update()
 {
+    const vector<stair_info> old_stairs = stairs;
+    const vector<short> old_distances = stair_distances;
+
     // First, set excludes, so that stair distances will be correctly populated.
     excludes = curr_excludes;
 
@@ -3592,6 +3663,9 @@ void LevelInfo::update()
     precompute_travel_safety_grid travel_safety_calc;
     update_stair_distances();
 
+    if (!_same_stairs(old_stairs, stairs) || old_distances != stair_distances)
+        _stair_graph_changed();
+
     vector<coord_def> transporter_positions;
     get_transporters(transporter_positions);
     correct_transporter_list(transporter_positions);
@@ -3612,9 +3686,12 @@ void LevelInfo::set_distance_between_stairs(int a, int b, int dist)
 void LevelInfo::update_stair_distances()
 {
     const int nstairs = stairs.size();
+    stair_fields.resize(nstairs * GXM * GYM);
+
     // Now we update distances for all the stairs, relative to all other
-    // stairs.
-    for (int s = 0; s < nstairs - 1; ++s)
+    // stairs, and keep the distances from each stair to every square so that
+    // interlevel travel to a square here never has to load this level.
+    for (int s = 0; s < nstairs; ++s)
     {
         set_distance_between_stairs(s, s, 0);
 
@@ -3630,9 +3707,33 @@ void LevelInfo::update_stair_distances()
             const int dist = travel_point_distance[op.x][op.y];
             set_distance_between_stairs(s, other, dist);
         }
+
+        short *field = &stair_fields[s * GXM * GYM];
+        for (int x = 0; x < GXM; ++x)
+            for (int y = 0; y < GYM; ++y)
+                field[x * GYM + y] = travel_point_distance[x][y];
     }
-    if (nstairs)
-        set_distance_between_stairs(nstairs - 1, nstairs - 1, 0);
+}
+
+bool LevelInfo::has_stair_fields() const
+{
+    return stair_fields.size() == stairs.size() * GXM * GYM;
+}
+
+// Work out the distances from each stair to every square again, for a level
+// not seen since the game was loaded. The level must be the current one, as
+// on a level_excursion.
+void LevelInfo::update_stair_fields()
+{
+    ASSERT(id == level_id::current());
+    if (has_stair_fields())
+        return;
+
+    unwind_var<exclude_set> level_excludes(curr_excludes, excludes);
+    const vector<short> old_distances = stair_distances;
+    update_stair_distances();
+    if (old_distances != stair_distances)
+        _stair_graph_changed();
 }
 
 void LevelInfo::update_transporter(const coord_def& transpos,
@@ -3667,6 +3768,7 @@ void LevelInfo::update_stair(const coord_def& stairpos, const level_pos &p,
     {
         si->destination = p;
         si->guessed_pos = guess;
+        _stair_graph_changed();
 
         if (!guess && p.id.branch == BRANCH_VESTIBULE
             && id.branch == BRANCH_DEPTHS)
@@ -3700,6 +3802,7 @@ void LevelInfo::create_placeholder_stair(const coord_def &stair,
     stairs.push_back(placeholder);
 
     resize_stair_distances();
+    _stair_graph_changed();
 }
 
 // If a stair leading out of or into a branch has a known destination, all
@@ -3745,6 +3848,7 @@ void LevelInfo::clear_stairs(dungeon_feature_type grid)
         si.destination.pos.y = -1;
         si.guessed_pos = true;
     }
+    _stair_graph_changed();
 }
 
 bool LevelInfo::know_transporter(const coord_def &c) const
@@ -3931,6 +4035,19 @@ int LevelInfo::distance_between(const stair_info *s1, const stair_info *s2)
     return stair_distances[ i1 * stairs.size() + i2 ];
 }
 
+int LevelInfo::distance_from_stair(const stair_info &si,
+                                   const coord_def &pos) const
+{
+    const int index = get_stair_index(si.position);
+    if (index == -1 || !has_stair_fields())
+        return -2;
+
+    const int dist = stair_fields[(index * GXM + pos.x) * GYM + pos.y];
+    if (!dist && pos != si.position || dist < -1)
+        return -1;
+    return dist;
+}
+
 void LevelInfo::get_transporters(vector<coord_def> &tr)
 {
     for (rectangle_iterator ri(1); ri; ++ri)
@@ -3961,12 +4078,6 @@ void LevelInfo::get_stairs(vector<coord_def> &st)
     }
 }
 
-void LevelInfo::clear_distances()
-{
-    for (stair_info &stair : stairs)
-        stair.clear_distance();
-}
-
 bool LevelInfo::is_known_branch(uint8_t branch) const
 {
     for (const stair_info &stair : stairs)
@@ -4361,10 +4472,10 @@ int TravelCache::get_waypoint_count() const
     return count;
 }
 
-void TravelCache::clear_distances()
+void TravelCache::erase_level_info(const level_id& lev)
 {
-    for (auto &entry : levels)
-        entry.second.clear_distances();
+    levels.erase(lev);
+    _stair_graph_changed();
 }
 
 bool TravelCache::is_known_branch(uint8_t branch) const
@@ -4415,6 +4526,7 @@ void TravelCache::load(reader& inf, int minorVersion)
 
         levels[id] = linfo;
     }
+    _stair_graph_changed();
 
 #if TAG_MAJOR_VERSION == 34
     if (minor < TAG_MINOR_MORE_WAYPOINTS)
@@ -277,19 +277,16 @@ public:
     dungeon_feature_type grid; // Grid feature of the stair.
     level_pos destination;  // The level and the position on the level this
                             // stair leads to. This may be a guess.
-    int       distance;     // The distance travelled to reach this stair.
     bool      guessed_pos;  // true if we're not sure that 'destination' is
                             // correct.
     stair_type type;
 
     stair_info()
         : position(-1, -1), grid(DNGN_FLOOR), destination(),
-          distance(-1), guessed_pos(true), type(PHYSICAL)
+          guessed_pos(true), type(PHYSICAL)
     {
     }
 
-    void clear_distance() { distance = -1; }
-
     void save(writer&) const;
     void load(reader&);
 
@@ -329,7 +326,8 @@ public:
 // Information on a level that interlevel travel needs.
 struct LevelInfo
 {
-    LevelInfo() : stairs(), excludes(), stair_distances(), id()
+    LevelInfo() : stairs(), excludes(), stair_distances(), stair_fields(),
+                  id()
     {
         daction_counters.init(0);
     }
@@ -355,7 +353,6 @@ struct LevelInfo
     int get_stair_index(const coord_def &pos) const;
     int get_transporter_index(const coord_def &pos) const;
 
-    void clear_distances();
     void set_level_excludes();
 
     const exclude_set &get_excludes() const
@@ -367,6 +364,13 @@ struct LevelInfo
     // or does not exist in our list of stairs, returns 0.
     int distance_between(const stair_info *s1, const stair_info *s2) const;
 
+    // Returns the travel distance from a stair to pos, -1 if pos can't be
+    // reached from it, or -2 if we don't know because the level hasn't been
+    // updated since the game was loaded.
+    int distance_from_stair(const stair_info &si, const coord_def &pos) const;
+    bool has_stair_fields() const;
+    void update_stair_fields();
+
     void update_excludes();
     void update();              // Update LevelInfo to be correct for the
                                 // current level.
@@ -407,6 +411,9 @@ private:
     exclude_set excludes;
 
     vector<short> stair_distances;  // Dist between stairs
+    // Distances from each stair to every square, GXM * GYM per stair. Not
+    // saved; see update_stair_fields().
+    vector<short> stair_fields;
     level_id id;
 
     friend class TravelCache;
@@ -421,8 +428,6 @@ const int TRAVEL_WAYPOINT_COUNT = 100;
 class TravelCache
 {
 public:
-    void clear_distances();
-
     LevelInfo& get_level_info(const level_id &lev)
     {
         LevelInfo &li = levels[lev];
@@ -436,10 +441,7 @@ public:
         return i != levels.end()? &i->second : nullptr;
     }
 
-    void erase_level_info(const level_id& lev)
-    {
-        levels.erase(lev);
-    }
+    void erase_level_info(const level_id& lev);
 
     bool know_stair(const coord_def &c);
     bool know_transporter(const coord_def &c);
@@ -553,42 +553,59 @@ static void _maybe_gozag_incite(vector<monster*> monsters)
         gozag_incite(mon);
 }
 
+static void _update_monster_in_view(monster &mon, int &num_hostile,
+                                    vector<string> &msgs,
+                                    vector<monster*> &monsters)
+{
+    if (mon.attitude == ATT_HOSTILE)
+        num_hostile++;
+
+    if (mon.visible_to(&you))
+    {
+        if (handle_seen_interrupt(&mon, &msgs))
+            monsters.push_back(&mon);
+        seen_monster(&mon);
+    }
+    else
+        mon.flags &= ~MF_WAS_IN_VIEW;
+}
+
 void update_monsters_in_view()
 {
     int num_hostile = 0;
     vector<string> msgs;
     vector<monster*> monsters;
 
-    for (monster_iterator mi; mi; ++mi)
+    // Once the player's turn is over, only monsters in view need updating,
+    // and those are all close by.
+    if (you.turn_is_over && !crawl_state.game_is_arena()
+        && !crawl_state.arena_suspended)
     {
-        if (you.see_cell(mi->pos()))
-        {
-            if (mi->attitude == ATT_HOSTILE)
-                num_hostile++;
-
-            if (mi->visible_to(&you))
-            {
-                if (handle_seen_interrupt(*mi, &msgs))
-                    monsters.push_back(*mi);
-                seen_monster(*mi);
-            }
-            else
-                mi->flags &= ~MF_WAS_IN_VIEW;
-        }
-        else if (!you.turn_is_over)
+        for (monster_radius_iterator mi(you.pos(), LOS_RADIUS); mi; ++mi)
+            if (you.see_cell(mi->pos()))
+                _update_monster_in_view(**mi, num_hostile, msgs, monsters);
+    }
+    else
+    {
+        for (monster_iterator mi; mi; ++mi)
         {
-            if (mi->flags & MF_WAS_IN_VIEW)
+            if (you.see_cell(mi->pos()))
+                _update_monster_in_view(**mi, num_hostile, msgs, monsters);
+            else if (!you.turn_is_over)
             {
-                // Reset client id so the player doesn't know (for sure) he
-                // has seen this monster before when it reappears.
-                mi->reset_client_id();
-            }
+                if (mi->flags & MF_WAS_IN_VIEW)
+                {
+                    // Reset client id so the player doesn't know (for sure) he
+                    // has seen this monster before when it reappears.
+                    mi->reset_client_id();
+                }
 
-            mi->flags &= ~MF_WAS_IN_VIEW;
+                mi->flags &= ~MF_WAS_IN_VIEW;
 
-            // If the monster hasn't been seen by the time that the player
-            // gets control back then seen_context is out of date.
-            mi->seen_context = SC_NONE;
+                // If the monster hasn't been seen by the time that the player
+                // gets control back then seen_context is out of date.
+                mi->seen_context = SC_NONE;
+            }
         }
     }
 
@@ -80,8 +80,8 @@ function ($, comm, map_knowledge, view_data, monster_list, minimap,
         if (data.vgrdc)
             minimap.do_view_center_update(data.vgrdc.x, data.vgrdc.y);
 
-        if (data.cells)
-            map_knowledge.merge(data.cells);
+        if (data.cells || data.bin)
+            map_knowledge.merge(data.cells, data.bin);
 
         // Mark cells overlapped by dirty cells as dirty
         $.each(map_knowledge.dirty().slice(), function (i, loc) {
@@ -105,6 +105,14 @@ function ($, comm, map_knowledge, view_data, monster_list, minimap,
         "map": handle_map_message,
     });
 
+    // Let the server know we can read packed map cells; it decides whether
+    // crawl actually sends them.
+    $(document).off("game_init.display")
+        .on("game_init.display", function () {
+            comm.send_message("map_encoding_support",
+                              {version: map_knowledge.map_encoding});
+        });
+
     return {
         invalidate: invalidate,
         display: display,
@@ -197,19 +197,139 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
 
     }
 
-    function merge_diff(vals)
+    // Packed map cells; see _pack_cell() in tileweb.cc for the format.
+    var MAP_ENCODING_VERSION = 1;
+    var packed_flags = ["bloody", "old_blood", "silenced",
+                        "highlighted_summoner", "sanctuary", "blasphemy",
+                        "has_bfb_corpse", "liquefied", "quad_glow",
+                        "disjunct", "mangrove_water", "awakened_forest"];
+
+    function unpack_cells(bin)
     {
-        $.each(vals, function (i, val)
+        var data = atob(bin);
+        var pos = 0;
+        var cells = [];
+
+        function uint()
+        {
+            var v = 0, shift = 0, b;
+            do
+            {
+                b = data.charCodeAt(pos++);
+                v |= (b & 0x7f) << shift;
+                shift += 7;
+            } while (b & 0x80);
+            return v >>> 0;
+        }
+
+        function sint()
+        {
+            var v = uint();
+            return (v >>> 1) ^ -(v & 1);
+        }
+
+        function tileidx()
+        {
+            var lo = uint() | 0;
+            var hi = uint() | 0;
+            return hi ? [lo, hi] : lo;
+        }
+
+        while (pos < data.length)
+        {
+            var mask = uint();
+            var cell = {};
+            var t = {};
+            var i, n;
+            if (mask & (1 << 0))
+            {
+                cell.x = sint();
+                cell.y = sint();
+            }
+            if (mask & (1 << 1))
+                cell.f = uint();
+            if (mask & (1 << 2))
+                cell.mf = uint();
+            if (mask & (1 << 3))
+                cell.g = String.fromCodePoint(uint());
+            if (mask & (1 << 4))
+                cell.col = uint();
+            if (mask & (1 << 5))
+                cell.flc = uint();
+            if (mask & (1 << 6))
+                cell.fla = uint();
+            if (mask & (1 << 7))
+                t.fg = tileidx();
+            if (mask & (1 << 8))
+                t.base = uint();
+            if (mask & (1 << 9))
+                t.bg = tileidx();
+            if (mask & (1 << 10))
+                t.cloud = tileidx();
+            if (mask & (1 << 11))
+            {
+                t.icons = [];
+                for (i = 0, n = uint(); i < n; i++)
+                    t.icons.push(tileidx());
+            }
+            if (mask & (1 << 12))
+            {
+                var changed = uint();
+                var values = uint();
+                for (i = 0; i < packed_flags.length; i++)
+                    if (changed & (1 << i))
+                        t[packed_flags[i]] = !!(values & (1 << i));
+            }
+            if (mask & (1 << 13))
+                t.halo = sint();
+            if (mask & (1 << 14))
+                t.orb_glow = uint();
+            if (mask & (1 << 15))
+                t.blood_rotation = sint();
+            if (mask & (1 << 16))
+                t.travel_trail = uint();
+            if (mask & (1 << 17))
+            {
+                t.flv = {f: uint()};
+                var special = uint();
+                if (special)
+                    t.flv.s = special;
+            }
+            if (mask & (1 << 18))
+            {
+                t.ov = [];
+                for (i = 0, n = uint(); i < n; i++)
+                    t.ov.push(sint());
+            }
+            if (mask & ~((1 << 7) - 1))
+                cell.t = t;
+            cells.push(cell);
+        }
+        return cells;
+    }
+
+    function merge_diff(vals, bin)
+    {
+        $.each(vals || [], function (i, val)
                {
                    merge(val);
                });
 
+        if (bin)
+        {
+            $.each(unpack_cells(bin), function (i, val)
+                   {
+                       merge(val);
+                   });
+        }
+
         clean_monster_table();
     };
 
     return {
         get: get,
         merge: merge_diff,
+        map_encoding: MAP_ENCODING_VERSION,
         clear: clear,
         touch: touch,
         visible: visible,
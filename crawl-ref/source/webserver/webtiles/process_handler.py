@@ -120,6 +120,10 @@ class CrawlProcessHandlerBase(object):
         self.process = None
         self.client_path = self.config_path("client_path")
         self.crawl_version = None
+        # packed map cell formats: the newest one crawl can send, and the one
+        # it has been told to use
+        self.crawl_map_encoding = 0
+        self.map_encoding = 0
         self.where = {}
         self.wheretime = 0
         self.last_milestone = None
@@ -573,6 +577,7 @@ class CrawlProcessHandlerBase(object):
                 watcher.send_json_options(self.game_params.id, self.username)
         self._receivers.add(watcher)
         self.update_watcher_description()
+        self.update_map_encoding()
 
     def remove_watcher(self, watcher):
         # if both users quit around the same time, this can get out of sync;
@@ -580,6 +585,23 @@ class CrawlProcessHandlerBase(object):
         if watcher in self._receivers:
             self._receivers.remove(watcher)
             self.update_watcher_description()
+            self.update_map_encoding()
+
+    def update_map_encoding(self):
+        # Map messages go to every receiver alike, so crawl may only pack map
+        # cells in a format that all of them can read. This is opt-in per
+        # game, with the `packed_map` game option.
+        version = 0
+        if self.game_params.get("packed_map", False) and self._receivers:
+            version = min([self.crawl_map_encoding]
+                          + [getattr(r, "map_encoding", 0)
+                             for r in self._receivers])
+        if version != self.map_encoding:
+            self.map_encoding = version
+            self._send_map_encoding(version)
+
+    def _send_map_encoding(self, version):
+        pass
 
     def watcher_count(self):
         return len([w for w in self._receivers if w.watched_game and not w.chat_hidden])
@@ -592,6 +614,8 @@ class CrawlProcessHandlerBase(object):
                                            self.username)
 
     def _send_client(self, watcher):
+        # the new client announces its own map encoding support once loaded
+        watcher.map_encoding = 0
         h = hashlib.sha1(utf8(os.path.abspath(self.client_path)))
         if self.crawl_version:
             h.update(utf8(self.crawl_version))
@@ -1046,6 +1070,13 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
         super(CrawlProcessHandler, self).handle_process_end()
 
 
+    def _send_map_encoding(self, version):
+        if self.conn and self.conn.open:
+            self.conn.send_message(json_encode({
+                        "msg": "map_encoding",
+                        "version": version
+                        }))
+
     def add_watcher(self, watcher):
         super(CrawlProcessHandler, self).add_watcher(watcher)
 
@@ -1163,6 +1194,8 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
                         self.crawl_version = msgobj["version"]
                         self.logger.info("Crawl version: %s.", self.crawl_version)
                     self.send_client_to_all()
+                self.crawl_map_encoding = msgobj.get("map_encoding", 0)
+                self.update_map_encoding()
             elif msgobj["msg"] == "flush_messages":
                 # only queue, once we know the crawl process asks for flushes
                 # note: every version since 0.13 supports this
@@ -317,6 +317,7 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
         self.subprotocol = None
 
         self.chat_hidden = False
+        self.map_encoding = 0
 
         self.logger = logging.LoggerAdapter(logging.getLogger(), {})
         self.logger.process = self._process_log_msg
@@ -330,6 +331,7 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
             "pong": self.pong,
             "watch": self.watch,
             "chat_msg": self.post_chat_message,
+            "map_encoding_support": self.map_encoding_support,
             "register": self.register,
             "start_change_email": self.start_change_email,
             "change_email": self.change_email,
@@ -1095,6 +1097,14 @@ class CrawlWebSocket(tornado.websocket.WebSocketHandler):
                 self.stop_watching()
             self.go_lobby()
 
+    def map_encoding_support(self, version):
+        # sent by game clients that can read packed map cells, once they
+        # have loaded
+        self.map_encoding = version
+        game = self.process or self.watched_game
+        if game:
+            game.update_map_encoding()
+
     def post_chat_message(self, text):
         max_length = config.get('max_chat_length')
         if max_length: